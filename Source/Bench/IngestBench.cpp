@@ -0,0 +1,358 @@
+/*
+ * This file is part of ShowMIDI.
+ * Copyright (command) 2023 Uwyn LLC.  https://www.uwyn.com
+ *
+ * ShowMIDI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ShowMIDI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <JuceHeader.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "../MidiDeviceComponent.h"
+#include "../MidiDeviceState.h"
+#include "../PluginSettings.h"
+#include "../SettingsManager.h"
+
+// every heap allocation of the process goes through these, they're only
+// counted while a measurement is running
+static std::atomic<bool> countAllocations { false };
+static std::atomic<juce::int64> numAllocations { 0 };
+
+void* operator new(size_t size)
+{
+    if (countAllocations.load(std::memory_order_relaxed))
+    {
+        numAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (auto p = std::malloc(size > 0 ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)                   { return operator new(size); }
+void operator delete(void* p) noexcept              { std::free(p); }
+void operator delete[](void* p) noexcept            { std::free(p); }
+void operator delete(void* p, size_t) noexcept      { std::free(p); }
+void operator delete[](void* p, size_t) noexcept    { std::free(p); }
+
+namespace showmidi
+{
+    // headless stand-in for the editor, with the default display settings
+    class BenchSettingsManager : public SettingsManager
+    {
+    public:
+        BenchSettingsManager()
+        {
+            settings_.setVisualization(Settings::DEFAULT_VISUALIZATION);
+            settings_.setTimeoutDelay(Settings::DEFAULT_TIMEOUT_DELAY);
+        }
+
+        bool isPlugin() override                                { return true; }
+        Component* getTopLevelComponent() override              { return nullptr; }
+        Settings& getSettings() override                        { return settings_; }
+        void applySettings() override                           {}
+        void storeSettings() override                           {}
+        MidiDevicesListeners& getMidiDevicesListeners() override { return listeners_; }
+
+    private:
+        PluginSettings settings_;
+        MidiDevicesListeners listeners_;
+    };
+
+    // the synthetic streams are generated up front from a fixed seed, so
+    // that every run replays exactly the same messages
+    class BenchStreams
+    {
+    public:
+        static constexpr int SEED = 0x5107;
+
+        // 300 BPM at 24 pulses per quarter note
+        static constexpr double CLOCK_INTERVAL = 60.0 / (300.0 * 24.0);
+
+        static Array<MidiMessage> noteStorm(int count)
+        {
+            Random random(SEED);
+            Array<MidiMessage> result;
+            result.ensureStorageAllocated(count);
+            while (result.size() < count)
+            {
+                auto channel = 1 + random.nextInt(16);
+                auto note = random.nextInt(128);
+                result.add(MidiMessage::noteOn(channel, note, uint8(1 + random.nextInt(127))));
+                result.add(MidiMessage::noteOff(channel, note, uint8(random.nextInt(128))));
+            }
+            return result;
+        }
+
+        static Array<MidiMessage> mpe(int count)
+        {
+            Random random(SEED);
+            Array<MidiMessage> result;
+            result.ensureStorageAllocated(count);
+
+            // MPE configuration message for a lower zone with 15 member channels
+            result.add(MidiMessage::controllerEvent(1, 101, 0));
+            result.add(MidiMessage::controllerEvent(1, 100, 6));
+            result.add(MidiMessage::controllerEvent(1, 6, 15));
+
+            auto member = 0;
+            while (result.size() < count)
+            {
+                auto channel = 2 + member;
+                member = (member + 1) % 15;
+
+                auto note = 36 + random.nextInt(48);
+                result.add(MidiMessage::noteOn(channel, note, uint8(1 + random.nextInt(127))));
+                for (auto i = 0; i < 32; ++i)
+                {
+                    result.add(MidiMessage::pitchWheel(channel, 8192 + int(4000.0 * std::sin(i * 0.3))));
+                    result.add(MidiMessage::channelPressureChange(channel, random.nextInt(128)));
+                    result.add(MidiMessage::controllerEvent(channel, 74, random.nextInt(128)));
+                }
+                result.add(MidiMessage::noteOff(channel, note, uint8(64)));
+            }
+            return result;
+        }
+
+        static Array<MidiMessage> nrpnSweep(int count)
+        {
+            Random random(SEED);
+            Array<MidiMessage> result;
+            result.ensureStorageAllocated(count);
+
+            auto number = 0;
+            while (result.size() < count)
+            {
+                auto channel = 1 + random.nextInt(16);
+                number = (number + 1) % 1024;
+                auto value = random.nextInt(16384);
+                result.add(MidiMessage::controllerEvent(channel, 99, number >> 7));
+                result.add(MidiMessage::controllerEvent(channel, 98, number & 0x7f));
+                result.add(MidiMessage::controllerEvent(channel, 6, value >> 7));
+                result.add(MidiMessage::controllerEvent(channel, 38, value & 0x7f));
+            }
+            return result;
+        }
+
+        static Array<MidiMessage> highResolutionControlChanges(int count)
+        {
+            Random random(SEED);
+            Array<MidiMessage> result;
+            result.ensureStorageAllocated(count);
+            while (result.size() < count)
+            {
+                auto channel = 1 + random.nextInt(16);
+                auto number = random.nextInt(32);
+                auto value = random.nextInt(16384);
+                result.add(MidiMessage::controllerEvent(channel, number, value >> 7));
+                result.add(MidiMessage::controllerEvent(channel, number + 32, value & 0x7f));
+            }
+            return result;
+        }
+
+        // the ticks carry their time in seconds from the start of the
+        // stream, they're ingested at those times instead of when they're
+        // pushed, so that the tempo is estimated like for a real device
+        static Array<MidiMessage> clock(int count)
+        {
+            Random random(SEED);
+            Array<MidiMessage> result;
+            result.ensureStorageAllocated(count);
+
+            result.add(MidiMessage::midiStart());
+            auto time_stamp = 0.0;
+            while (result.size() < count)
+            {
+                // a bit of delivery jitter, like a real MIDI interface
+                time_stamp += CLOCK_INTERVAL;
+                auto tick = MidiMessage::midiClock();
+                tick.setTimeStamp(time_stamp + (random.nextDouble() - 0.5) * 0.0005);
+                result.add(tick);
+            }
+            return result;
+        }
+
+        static Array<MidiMessage> sysexDumps(int count)
+        {
+            Random random(SEED);
+            Array<MidiMessage> result;
+            result.ensureStorageAllocated(count);
+
+            uint8 data[512];
+            while (result.size() < count)
+            {
+                // non-commercial manufacturer id
+                data[0] = 0x7d;
+                for (auto i = 1; i < int(sizeof(data)); ++i)
+                {
+                    data[i] = uint8(random.nextInt(128));
+                }
+                result.add(MidiMessage::createSysExMessage(data, int(sizeof(data))));
+            }
+            return result;
+        }
+    };
+
+    class IngestBench
+    {
+    public:
+        // roughly what a busy rig sends between two renders at 30Hz
+        static constexpr int MESSAGES_PER_FRAME = 256;
+
+        // the start of every stream isn't measured, to let the pools grow
+        static constexpr int WARM_UP_DIVISOR = 10;
+
+        IngestBench()
+        {
+            std::printf("%-16s %8s %12s %27s %27s %11s\n", "stream", "devices", "msgs/sec",
+                        "push ns p50/p99/p99.9", "ingest ns p50/p99/p99.9", "allocs/msg");
+        }
+
+        // timed streams are pushed straight into the event queues, with the
+        // time stamps of their messages on top of the start of the run,
+        // other streams go through the device and are stamped on arrival
+        void run(const char* name, const Array<MidiMessage>& messages, int numDevices = 1, bool timed = false)
+        {
+            OwnedArray<MidiDeviceState> states;
+            OwnedArray<MidiDeviceComponent> devices;
+            for (auto i = 0; i < numDevices; ++i)
+            {
+                auto state = states.add(new MidiDeviceState(settingsManager_.getSettings()));
+                devices.add(new MidiDeviceComponent(&settingsManager_, String("Bench ") + String(i + 1), *state));
+            }
+            const auto run_start = currentTicks();
+
+            auto warm_up = messages.size() / WARM_UP_DIVISOR;
+
+            std::vector<double> push_ns;
+            std::vector<double> ingest_ns;
+            push_ns.reserve(size_t(messages.size() * numDevices));
+            ingest_ns.reserve(size_t(messages.size() / MESSAGES_PER_FRAME + 1));
+
+            auto ticks_per_ns = double(Time::getHighResolutionTicksPerSecond()) / 1000000000.0;
+            auto total_ticks = int64(0);
+            auto total_messages = int64(0);
+
+            for (auto start = 0; start < messages.size(); start += MESSAGES_PER_FRAME)
+            {
+                auto end = std::min(messages.size(), start + MESSAGES_PER_FRAME);
+                auto measured = start >= warm_up;
+                if (measured)
+                {
+                    countAllocations = true;
+                }
+
+                auto frame_start = Time::getHighResolutionTicks();
+                for (auto i = start; i < end; ++i)
+                {
+                    // with several devices, they all receive the stream interleaved
+                    auto& message = messages.getReference(i);
+                    for (auto d = 0; d < numDevices; ++d)
+                    {
+                        auto push_start = Time::getHighResolutionTicks();
+                        if (timed)
+                        {
+                            states[d]->getQueue().push(run_start + Ticks(message.getTimeStamp() * TICKS_PER_SECOND), message);
+                        }
+                        else
+                        {
+                            devices[d]->handleIncomingMidiMessage(message);
+                        }
+                        if (measured)
+                        {
+                            push_ns.push_back(double(Time::getHighResolutionTicks() - push_start) / ticks_per_ns);
+                        }
+                    }
+                }
+
+                auto render_start = Time::getHighResolutionTicks();
+                for (auto device : devices)
+                {
+                    device->render();
+                }
+                auto frame_end = Time::getHighResolutionTicks();
+
+                countAllocations = false;
+                if (measured)
+                {
+                    auto num_messages = (end - start) * numDevices;
+                    ingest_ns.push_back(double(frame_end - render_start) / ticks_per_ns / num_messages);
+                    total_ticks += frame_end - frame_start;
+                    total_messages += num_messages;
+                }
+            }
+
+            auto seconds = double(total_ticks) / double(Time::getHighResolutionTicksPerSecond());
+            auto allocations = numAllocations.exchange(0);
+
+            std::printf("%-16s %8d %12.0f %27s %27s %11.4f\n", name, numDevices,
+                        seconds > 0.0 ? double(total_messages) / seconds : 0.0,
+                        percentiles(push_ns).toRawUTF8(),
+                        percentiles(ingest_ns).toRawUTF8(),
+                        total_messages > 0 ? double(allocations) / double(total_messages) : 0.0);
+        }
+
+    private:
+        static String percentiles(std::vector<double>& samples)
+        {
+            if (samples.empty())
+            {
+                return "-";
+            }
+
+            std::sort(samples.begin(), samples.end());
+            auto at = [&samples] (double fraction)
+            {
+                return String(samples[std::min(samples.size() - 1, size_t(fraction * double(samples.size())))], 1);
+            };
+            return at(0.5) + " / " + at(0.99) + " / " + at(0.999);
+        }
+
+        BenchSettingsManager settingsManager_;
+
+        JUCE_DECLARE_NON_COPYABLE (IngestBench)
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace showmidi;
+
+    ScopedJuceInitialiser_GUI juce_initialiser;
+
+    // the number of messages per stream can be passed as the only argument
+    auto count = 200000;
+    if (argc > 1)
+    {
+        count = std::max(IngestBench::MESSAGES_PER_FRAME * IngestBench::WARM_UP_DIVISOR, String(argv[1]).getIntValue());
+    }
+
+    IngestBench bench;
+    bench.run("note storm", BenchStreams::noteStorm(count));
+    bench.run("mpe", BenchStreams::mpe(count));
+    bench.run("nrpn sweep", BenchStreams::nrpnSweep(count));
+    bench.run("14-bit cc", BenchStreams::highResolutionControlChanges(count));
+    bench.run("clock 300 bpm", BenchStreams::clock(count), 1, true);
+    bench.run("sysex dumps", BenchStreams::sysexDumps(count / 100));
+
+    // eight MPE controllers on one stage rig, each with its own device
+    bench.run("mpe stage rig", BenchStreams::mpe(count / 8), 8);
+
+    return 0;
+}
@@ -19,216 +19,753 @@
 
 namespace showmidi
 {
+    // state is timed with monotonic microsecond ticks, on the time base of
+    // Time::getMillisecondCounterHiRes(), so that wall clock adjustments
+    // don't affect expiry and graphs; incoming messages are stamped with
+    // these ticks when they're received, zero means that something never
+    // happened
+    typedef int64 Ticks;
+    static constexpr Ticks TICKS_PER_MS = 1000;
+    static constexpr Ticks TICKS_PER_SECOND = 1000 * TICKS_PER_MS;
+    
+    inline Ticks currentTicks()
+    {
+        return Ticks(Time::getMillisecondCounterHiRes() * TICKS_PER_MS);
+    }
+    
+    // graphs scroll by one pixel column per render time unit
+    static constexpr int RENDER_TIME_UNIT_MS = 50;
+    static constexpr Ticks RENDER_TIME_UNIT_TICKS = RENDER_TIME_UNIT_MS * TICKS_PER_MS;
+    
+    // the widest graphs, for pitch bend and parameters, span this many columns
+    static constexpr int MAX_GRAPH_WIDTH = 146;
+    
     struct TimedValue
     {
-        Time time_;
+        Ticks time_ { 0 };
         int value_ { 0 };
         
         void reset()
         {
-            time_ = Time();
+            time_ = 0;
             value_ = 0;
         }
     };
     
-    struct ChannelMessage
+    // fixed capacity ring of past values, ordered from newest to oldest
+    // the storage is allocated once, on first use, and never grows, adding
+    // and expiring values are constant time
+    class TimedValueHistory
     {
-        TimedValue current_;
-        std::vector<TimedValue> history_;
+    public:
+        // one value per graph column, with room for the column that's
+        // partially scrolled out and for the value that fills the graph
+        // up to its left edge
+        static constexpr int CAPACITY = MAX_GRAPH_WIDTH + 2;
         
-        void resetChannelMessage()
+        TimedValueHistory()
         {
-            current_.reset();
-            history_.clear();
         }
-    };
-    
-    struct NoteOn : public ChannelMessage
-    {
-        int number_ { -1 };
-        ChannelMessage polyPressure_;
         
-        void reset()
+        TimedValueHistory(const TimedValueHistory& other)
         {
-            resetChannelMessage();
-            polyPressure_.resetChannelMessage();
+            copy(other);
         }
-    };
-    
-    struct NoteOff : public ChannelMessage
-    {
-        int number_ { -1 };
-
-        void reset()
+        
+        TimedValueHistory& operator=(const TimedValueHistory& other)
         {
-            resetChannelMessage();
+            if (this != &other)
+            {
+                copy(other);
+            }
+            return *this;
         }
-    };
-    
-    struct Notes
-    {
-        Notes()
+        
+        static int64 graphColumn(Ticks t)
+        {
+            return (t + RENDER_TIME_UNIT_TICKS - 1) / RENDER_TIME_UNIT_TICKS;
+        }
+        
+        bool empty() const
+        {
+            return size_ == 0;
+        }
+        
+        int size() const
+        {
+            return size_;
+        }
+        
+        // index 0 is the newest value
+        const TimedValue& operator[](int index) const
+        {
+            return values_[(newest_ + index) % CAPACITY];
+        }
+        
+        const TimedValue& newest() const
         {
-            for (int i = 0; i < 128; ++i)
+            return (*this)[0];
+        }
+        
+        const TimedValue& oldest() const
+        {
+            return (*this)[size_ - 1];
+        }
+        
+        void addNewest(const TimedValue& value)
+        {
+            allocate();
+            
+            // only the latest value of a graph column is ever drawn, so a
+            // value that lands in the column of the newest one replaces it
+            if (size_ > 0 && graphColumn(value.time_) == graphColumn(newest().time_))
             {
-                noteOn_[i].number_ = i;
-                noteOff_[i].number_ = i;
+                values_[newest_] = value;
+                return;
             }
+            
+            // when the ring is full, this overwrites the oldest value
+            newest_ = (newest_ + CAPACITY - 1) % CAPACITY;
+            values_[newest_] = value;
+            size_ = std::min(size_ + 1, CAPACITY);
         }
         
-        Notes(const Notes& other)
+        void addOldest(const TimedValue& value)
         {
-            deepCopy(other);
+            if (size_ == CAPACITY)
+            {
+                return;
+            }
+            
+            allocate();
+            values_[(newest_ + size_) % CAPACITY] = value;
+            ++size_;
         }
         
-        Notes& operator=(Notes other)
+        void clear()
         {
-            deepCopy(other);
-            return *this;
+            newest_ = 0;
+            size_ = 0;
         }
         
-        void deepCopy(const Notes& other)
+    private:
+        void allocate()
         {
-            time_ = other.time_;
-            for (int i = 0; i < 128; ++i)
+            if (values_ == nullptr)
             {
-                noteOn_[i] = other.noteOn_[i];
-                noteOff_[i] = other.noteOff_[i];
+                values_.reset(new TimedValue[CAPACITY]);
             }
         }
         
-        void reset()
+        void copy(const TimedValueHistory& other)
         {
-            time_ = Time();
-            for (int i = 0; i < 128; ++i)
+            clear();
+            if (other.size_ > 0)
             {
-                noteOn_[i].reset();
-                noteOff_[i].reset();
+                allocate();
+                for (int i = 0; i < other.size_; ++i)
+                {
+                    values_[i] = other[i];
+                }
+                size_ = other.size_;
             }
         }
-
-        Time time_;
-        NoteOn noteOn_[128];
-        NoteOff noteOff_[128];
+        
+        std::unique_ptr<TimedValue[]> values_;
+        int newest_ { 0 };
+        int size_ { 0 };
     };
     
-    struct ControlChange : public ChannelMessage
+    // a new generation of state, for a holder of state pages that should
+    // not see the writes of the other holders of the same pages
+    inline uint32 nextStateGeneration()
     {
-        int number_ { -1 };
-
-        void reset()
+        static std::atomic<uint32> generation { 0 };
+        return ++generation;
+    }
+    
+    // a part of the state that's shared by the live state and its snapshots,
+    // until one of them writes to it: the writer then gets its own copy,
+    // stamped with its generation, so that later writes go straight to it;
+    // this makes a snapshot free to take, afterwards each page that's written
+    // to is copied once
+    template <typename T>
+    class StatePage
+    {
+    public:
+        explicit StatePage(uint32 generation = 0) :
+            content_(std::make_shared<Content>(generation))
+        {
+        }
+        
+        const T& read() const
+        {
+            return content_->value_;
+        }
+        
+        T& write(uint32 generation)
+        {
+            if (!isWritable(generation))
+            {
+                content_ = std::make_shared<Content>(generation, content_->value_);
+            }
+            return content_->value_;
+        }
+        
+        bool isWritable(uint32 generation) const
         {
-            resetChannelMessage();
+            return content_->generation_ == generation;
         }
+        
+    private:
+        struct Content
+        {
+            explicit Content(uint32 generation) : generation_(generation) {}
+            Content(uint32 generation, const T& value) : generation_(generation), value_(value) {}
+            
+            const uint32 generation_;
+            T value_;
+        };
+        
+        std::shared_ptr<Content> content_;
     };
     
-    struct ControlChanges
+    // the kinds of channel messages that keep a history for their graphs
+    enum HistoryKind
+    {
+        historyPolyPressure = 1,
+        historyControlChange,
+        historyChannelPressure,
+        historyPitchBend,
+        historyHrcc,
+        historyRpn,
+        historyNrpn
+    };
+    
+    // identifies the message a pooled history belongs to, from its channel,
+    // kind and 14-bit note, controller or parameter number
+    static inline uint32 historyOwner(int channel, HistoryKind kind)
+    {
+        return uint32(((channel + 1) << 20) | (kind << 14));
+    }
+    
+    // the histories of all messages of a device come from one pool of a
+    // bounded number of rings, that are handed out when a message first
+    // needs a history and taken back once it's too old to be graphed;
+    // messages only keep the index of their history, which is verified
+    // against the owner recorded in the pool, so that taking a history
+    // back doesn't require finding the message that used it
+    class HistoryPool
     {
-        ControlChanges()
+    public:
+        static constexpr int16 NO_HISTORY = -1;
+        static constexpr int MAX_HISTORIES = 512;
+        
+        void setGeneration(uint32 generation)
+        {
+            generation_ = generation;
+        }
+        
+        // the history of a message, or nullptr when it doesn't have one
+        const TimedValueHistory* find(int16 index, uint32 owner) const
         {
-            for (int i = 0; i < 128; ++i)
+            auto& slots = table_.read().slots_;
+            if (index < 0 || index >= int(slots.size()) || slots[size_t(index)].owner_ != owner)
             {
-                controlChange_[i].number_ = i;
+                return nullptr;
             }
+            return &slots[size_t(index)].history_.read();
         }
         
-        ControlChanges(const ControlChanges& other)
+        // the history of a message that was updated at a particular time,
+        // handing out a new one when needed, nullptr when the pool ran out
+        TimedValueHistory* acquire(int16& index, uint32 owner, Ticks t)
         {
-            deepCopy(other);
+            auto& table = table_.write(generation_);
+            if (index < 0 || index >= int(table.slots_.size()) || table.slots_[size_t(index)].owner_ != owner)
+            {
+                if (!table.free_.empty())
+                {
+                    index = table.free_.back();
+                    table.free_.pop_back();
+                }
+                else if (table.slots_.size() < MAX_HISTORIES)
+                {
+                    index = int16(table.slots_.size());
+                    table.slots_.emplace_back();
+                }
+                else
+                {
+                    index = NO_HISTORY;
+                    return nullptr;
+                }
+                
+                // the ring storage of a slot is reused, unless a snapshot
+                // still shows it
+                auto& slot = table.slots_[size_t(index)];
+                slot.owner_ = owner;
+                if (!slot.history_.isWritable(generation_))
+                {
+                    slot.history_ = StatePage<TimedValueHistory>(generation_);
+                }
+                slot.history_.write(generation_).clear();
+            }
+            
+            auto& slot = table.slots_[size_t(index)];
+            slot.updated_ = t;
+            return &slot.history_.write(generation_);
         }
         
-        ControlChanges& operator=(ControlChanges other)
+        // takes back the histories of messages that weren't updated since
+        // the cutoff, their ring storage is kept for reuse
+        void release(Ticks cutoff)
         {
-            deepCopy(other);
-            return *this;
+            auto released = false;
+            for (auto& slot : table_.read().slots_)
+            {
+                released = released || isReleased(slot, cutoff);
+            }
+            if (!released)
+            {
+                return;
+            }
+            
+            auto& table = table_.write(generation_);
+            for (size_t i = 0; i < table.slots_.size(); ++i)
+            {
+                auto& slot = table.slots_[i];
+                if (isReleased(slot, cutoff))
+                {
+                    slot.owner_ = 0;
+                    table.free_.push_back(int16(i));
+                }
+            }
         }
         
-        void deepCopy(const ControlChanges& other)
+        void reset()
         {
-            time_ = other.time_;
-            for (int i = 0; i < 128; ++i)
+            auto& table = table_.write(generation_);
+            table.free_.clear();
+            for (size_t i = table.slots_.size(); i > 0; --i)
             {
-                controlChange_[i] = other.controlChange_[i];
+                table.slots_[i - 1].owner_ = 0;
+                table.free_.push_back(int16(i - 1));
             }
         }
         
-        void reset()
+    private:
+        struct Slot
         {
-            time_ = Time();
-            for (int i = 0; i < 128; ++i)
+            uint32 owner_ { 0 };
+            Ticks updated_ { 0 };
+            StatePage<TimedValueHistory> history_;
+        };
+        
+        struct Table
+        {
+            Table()
+            {
+                slots_.reserve(MAX_HISTORIES);
+                free_.reserve(MAX_HISTORIES);
+            }
+            
+            Table(const Table& other) : Table()
             {
-                controlChange_[i].reset();
+                slots_ = other.slots_;
+                free_ = other.free_;
             }
+            
+            std::vector<Slot> slots_;
+            std::vector<int16> free_;
+        };
+        
+        static bool isReleased(const Slot& slot, Ticks cutoff)
+        {
+            return slot.owner_ != 0 && slot.updated_ < cutoff;
         }
-
-        Time time_;
-        ControlChange controlChange_[128];
+        
+        uint32 generation_ { 0 };
+        StatePage<Table> table_;
+    };
+    
+    // refers to one message of a kind that keeps a history
+    struct MessageRef
+    {
+        Ticks& time_;
+        int16& value_;
+        int16& history_;
+        uint32 owner_;
     };
     
-    struct ProgramChange : public ChannelMessage
+    // read-only counterpart of MessageRef
+    struct MessageView
     {
+        const Ticks& time_;
+        int value_;
+        int16 history_;
+        uint32 owner_;
+    };
+    
+    // the latest time and value of each message of a kind, one entry per
+    // note or controller number, in contiguous arrays
+    template <int SIZE>
+    struct MessageArray
+    {
+        MessageArray()
+        {
+            reset();
+        }
+        
         void reset()
         {
-            resetChannelMessage();
+            for (int i = 0; i < SIZE; ++i)
+            {
+                time_[i] = 0;
+                value_[i] = 0;
+            }
         }
+        
+        Ticks time_[SIZE];
+        int16 value_[SIZE];
     };
     
-    struct ChannelPressure : public ChannelMessage
+    // a message array with the index of the pooled history of each message
+    template <int SIZE>
+    struct HistoryMessageArray : public MessageArray<SIZE>
     {
+        HistoryMessageArray()
+        {
+            reset();
+        }
+        
         void reset()
         {
-            resetChannelMessage();
+            MessageArray<SIZE>::reset();
+            for (int i = 0; i < SIZE; ++i)
+            {
+                history_[i] = HistoryPool::NO_HISTORY;
+            }
         }
+        
+        MessageRef ref(int number)
+        {
+            return { this->time_[number], this->value_[number], history_[number], owner_ | uint32(number) };
+        }
+        
+        MessageView view(int number) const
+        {
+            return { this->time_[number], this->value_[number], history_[number], owner_ | uint32(number) };
+        }
+        
+        uint32 owner_ { 0 };
+        int16 history_[SIZE];
     };
     
-    struct PitchBend : public ChannelMessage
+    // the note or controller numbers of a channel that currently have
+    // something to display, kept in ascending order so that painting only
+    // visits those, with a bitset for constant time membership tests
+    class ActiveNumbers
     {
-        void reset()
+    public:
+        static constexpr int MAX_NUMBERS = 128;
+        
+        ActiveNumbers()
+        {
+            clear();
+        }
+        
+        bool contains(int number) const
+        {
+            return (bits_[number >> 6] >> (number & 63)) & 1;
+        }
+        
+        int size() const
+        {
+            return size_;
+        }
+        
+        int operator[](int index) const
+        {
+            return numbers_[index];
+        }
+        
+        void add(int number)
+        {
+            if (contains(number))
+            {
+                return;
+            }
+            
+            bits_[number >> 6] |= uint64(1) << (number & 63);
+            
+            auto index = size_;
+            while (index > 0 && numbers_[index - 1] > number)
+            {
+                numbers_[index] = numbers_[index - 1];
+                --index;
+            }
+            numbers_[index] = uint8(number);
+            ++size_;
+        }
+        
+        // removes the number at a position in the ascending order
+        void removeAt(int index)
+        {
+            auto number = numbers_[index];
+            bits_[number >> 6] &= ~(uint64(1) << (number & 63));
+            
+            --size_;
+            for (auto i = index; i < size_; ++i)
+            {
+                numbers_[i] = numbers_[i + 1];
+            }
+        }
+        
+        void clear()
         {
-            resetChannelMessage();
+            bits_[0] = 0;
+            bits_[1] = 0;
+            size_ = 0;
         }
+    
+    private:
+        uint64 bits_[2];
+        uint8 numbers_[MAX_NUMBERS];
+        int size_ { 0 };
     };
     
-    struct Parameter : public ChannelMessage
+    struct Notes
     {
         void reset()
         {
-            resetChannelMessage();
+            time_ = 0;
+            on_.reset();
+            off_.reset();
+            polyPressure_.reset();
+            active_.clear();
         }
+        
+        Ticks time_ { 0 };
+        ActiveNumbers active_;
+        MessageArray<128> on_;
+        MessageArray<128> off_;
+        HistoryMessageArray<128> polyPressure_;
     };
     
-    struct Parameters
+    struct ControlChanges
     {
-        Parameters()
+        void reset()
         {
+            time_ = 0;
+            controlChange_.reset();
+            active_.clear();
         }
         
-        Parameters(const Parameters& other)
+        Ticks time_ { 0 };
+        ActiveNumbers active_;
+        HistoryMessageArray<128> controlChange_;
+    };
+    
+    struct Parameter
+    {
+        Ticks time_ { 0 };
+        int16 value_ { 0 };
+        int16 history_ { HistoryPool::NO_HISTORY };
+    };
+
+    // fixed capacity open addressing table of parameters keyed by their
+    // 14-bit number, with the numbers also kept in ascending order for
+    // display; it never allocates, when it's full the parameter that was
+    // updated the longest ago makes room for the new one, which only
+    // happens with more than 48 live parameters of the same type, so that
+    // all 32 HRCC numbers always fit
+    class ParameterTable
+    {
+    public:
+        // a power of two, kept at most three quarters full
+        static constexpr int CAPACITY_BITS = 6;
+        static constexpr int CAPACITY = 1 << CAPACITY_BITS;
+        static constexpr int MAX_PARAMETERS = CAPACITY * 3 / 4;
+
+        ParameterTable()
         {
-            deepCopy(other);
+            clear();
         }
-        
-        Parameters& operator=(Parameters other)
+
+        int size() const
         {
-            deepCopy(other);
-            return *this;
+            return size_;
+        }
+
+        // the parameter number at a position in the ascending order
+        int numberAt(int index) const
+        {
+            return order_[index];
+        }
+
+        const Parameter* find(int number) const
+        {
+            return const_cast<ParameterTable*>(this)->find(number);
         }
         
-        void deepCopy(const Parameters& other)
+        Parameter* find(int number)
         {
-            time_ = other.time_;
-            param_.clear();
-            param_ = other.param_;
+            for (auto slot = home(number); slots_[slot].number_ != NO_NUMBER; slot = next(slot))
+            {
+                if (slots_[slot].number_ == number)
+                {
+                    return &slots_[slot].param_;
+                }
+            }
+            return nullptr;
+        }
+
+        // the parameter with a number, inserting it when it's not there yet
+        Parameter& operator[](int number)
+        {
+            auto param = find(number);
+            if (param != nullptr)
+            {
+                return *param;
+            }
+
+            if (size_ == MAX_PARAMETERS)
+            {
+                evictOldest();
+            }
+
+            auto slot = home(number);
+            while (slots_[slot].number_ != NO_NUMBER)
+            {
+                slot = next(slot);
+            }
+            slots_[slot].number_ = int16(number);
+            slots_[slot].param_ = Parameter();
+
+            auto index = size_;
+            while (index > 0 && order_[index - 1] > number)
+            {
+                order_[index] = order_[index - 1];
+                --index;
+            }
+            order_[index] = int16(number);
+            ++size_;
+
+            return slots_[slot].param_;
+        }
+
+        void remove(int number)
+        {
+            auto slot = home(number);
+            while (slots_[slot].number_ != number)
+            {
+                if (slots_[slot].number_ == NO_NUMBER)
+                {
+                    return;
+                }
+                slot = next(slot);
+            }
+
+            // shift the following entries of the probe sequence back, so
+            // that lookups never need tombstones
+            auto hole = slot;
+            for (slot = next(slot); slots_[slot].number_ != NO_NUMBER; slot = next(slot))
+            {
+                auto wanted = home(slots_[slot].number_);
+                if (((slot - wanted) & MASK) >= ((slot - hole) & MASK))
+                {
+                    slots_[hole] = slots_[slot];
+                    hole = slot;
+                }
+            }
+            slots_[hole].number_ = NO_NUMBER;
+
+            auto index = 0;
+            while (order_[index] != number)
+            {
+                ++index;
+            }
+            --size_;
+            for (auto i = index; i < size_; ++i)
+            {
+                order_[i] = order_[i + 1];
+            }
+        }
+
+        void clear()
+        {
+            for (auto& slot : slots_)
+            {
+                slot.number_ = NO_NUMBER;
+            }
+            size_ = 0;
+        }
+
+    private:
+        static constexpr int16 NO_NUMBER = -1;
+        static constexpr int MASK = CAPACITY - 1;
+
+        static int home(int number)
+        {
+            return int((uint32(number) * 2654435761u) >> (32 - CAPACITY_BITS)) & MASK;
+        }
+
+        static int next(int slot)
+        {
+            return (slot + 1) & MASK;
+        }
+
+        void evictOldest()
+        {
+            auto oldest = order_[0];
+            auto oldest_time = find(oldest)->time_;
+            for (auto i = 1; i < size_; ++i)
+            {
+                auto param = find(order_[i]);
+                if (param->time_ < oldest_time)
+                {
+                    oldest = order_[i];
+                    oldest_time = param->time_;
+                }
+            }
+            remove(oldest);
         }
 
-        Time time_;
-        std::map<int, Parameter> param_;
+        struct Slot
+        {
+            int16 number_ { NO_NUMBER };
+            Parameter param_;
+        };
+
+        Slot slots_[CAPACITY];
+        int16 order_[MAX_PARAMETERS];
+        int size_ { 0 };
+    };
+
+    struct Parameters
+    {
+        MessageRef ref(int number)
+        {
+            auto& param = param_[number];
+            return { param.time_, param.value_, param.history_, owner_ | uint32(number) };
+        }
+        
+        // a parameter that's in the table
+        MessageView view(int number) const
+        {
+            auto& param = *param_.find(number);
+            return { param.time_, param.value_, param.history_, owner_ | uint32(number) };
+        }
         
         void reset()
         {
-            time_ = Time();
+            time_ = 0;
             param_.clear();
         }
+        
+        uint32 owner_ { 0 };
+        Ticks time_ { 0 };
+        ParameterTable param_;
     };
     
     enum MpeMember
@@ -240,13 +777,25 @@ namespace showmidi
     
     struct ActiveChannel
     {
+        void setNumber(int number)
+        {
+            number_ = number;
+            notes_.polyPressure_.owner_ = historyOwner(number, historyPolyPressure);
+            controlChanges_.controlChange_.owner_ = historyOwner(number, historyControlChange);
+            channelPressure_.owner_ = historyOwner(number, historyChannelPressure);
+            pitchBend_.owner_ = historyOwner(number, historyPitchBend);
+            hrccs_.owner_ = historyOwner(number, historyHrcc);
+            rpns_.owner_ = historyOwner(number, historyRpn);
+            nrpns_.owner_ = historyOwner(number, historyNrpn);
+        }
+        
         int number_ { -1 };
-        Time time_;
+        Ticks time_ { 0 };
         Notes notes_;
         ControlChanges controlChanges_;
-        ProgramChange programChange_;
-        ChannelPressure channelPressure_;
-        PitchBend pitchBend_;
+        MessageArray<1> programChange_;
+        HistoryMessageArray<1> channelPressure_;
+        HistoryMessageArray<1> pitchBend_;
         Parameters hrccs_;
         Parameters rpns_;
         Parameters nrpns_;
@@ -260,7 +809,7 @@ namespace showmidi
         
         void reset()
         {
-            time_ = Time();
+            time_ = 0;
             notes_.reset();
             controlChanges_.reset();
             programChange_.reset();
@@ -298,7 +847,7 @@ namespace showmidi
             return *this;
         }
         
-        Time time_;
+        Ticks time_ { 0 };
         uint8 data_[MAX_SYSEX_DATA] { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
         int length_ { 0 };
         
@@ -311,7 +860,7 @@ namespace showmidi
         
         void reset()
         {
-            time_ = Time();
+            time_ = 0;
             memset(data_, 0, MAX_SYSEX_DATA);
             length_ = 0;
         }
@@ -334,15 +883,19 @@ namespace showmidi
             return *this;
         }
         
-        Time timeBpm_;
-        Time timeStart_;
-        Time timeContinue_;
-        Time timeStop_;
-        Time timeSpp_;
+        Ticks timeBpm_ { 0 };
+        Ticks timeStart_ { 0 };
+        Ticks timeContinue_ { 0 };
+        Ticks timeStop_ { 0 };
+        Ticks timeSpp_ { 0 };
         
         double bpm_ { 0.0 };
         int spp_ { 0 };
         
+        // the transport of the plugin host, when it provides a tempo
+        Ticks timeHost_ { 0 };
+        bool playing_ { false };
+        
         void deepCopy(const Clock& other)
         {
             timeBpm_ = other.timeBpm_;
@@ -352,18 +905,22 @@ namespace showmidi
             timeSpp_ = other.timeSpp_;
             bpm_ = other.bpm_;
             spp_ = other.spp_;
+            timeHost_ = other.timeHost_;
+            playing_ = other.playing_;
         }
         
         void reset()
         {
-            timeBpm_ = Time();
-            timeStart_ = Time();
-            timeContinue_ = Time();
-            timeStop_ = Time();
-            timeSpp_ = Time();
+            timeBpm_ = 0;
+            timeStart_ = 0;
+            timeContinue_ = 0;
+            timeStop_ = 0;
+            timeSpp_ = 0;
             
             bpm_ = 0.0;
             spp_ = 0;
+            timeHost_ = 0;
+            playing_ = false;
         }
     };
     
@@ -376,33 +933,35 @@ namespace showmidi
         {
             for (int i = 0; i < 16; ++i)
             {
-                channel_[i].number_ = i;
+                writeChannel(i).setNumber(i);
             }
         }
         
-        ActiveChannels(const ActiveChannels& other)
+        ActiveChannels(ActiveChannels&&) = default;
+        ActiveChannels& operator=(ActiveChannels&&) = default;
+        
+        // a read-only view of the state as it is now, the pages are shared
+        // and both sides continue in a new generation, so that they copy a
+        // page before writing to it
+        ActiveChannels snapshot()
         {
-            deepCopy(other);
+            ActiveChannels frozen(*this);
+            frozen.setGeneration(nextStateGeneration());
+            setGeneration(nextStateGeneration());
+            return frozen;
         }
         
-        ActiveChannels& operator=(ActiveChannels other)
+        const ActiveChannel& channel(int number) const
         {
-            deepCopy(other);
-            return *this;
+            return channel_[number].read();
         }
         
-        void deepCopy(const ActiveChannels& other)
+        ActiveChannel& writeChannel(int number)
         {
-            sysex_ = other.sysex_;
-            clock_ = other.clock_;
-            
-            for (int i = 0; i < 16; ++i)
-            {
-                channel_[i] = other.channel_[i];
-            }
+            return channel_[number].write(generation_);
         }
-
-        ActiveChannel channel_[16];
+        
+        HistoryPool histories_;
         
         void reset()
         {
@@ -410,11 +969,12 @@ namespace showmidi
             clock_.reset();
             for (int i = 0; i < 16; ++i)
             {
-                channel_[i].reset();
+                writeChannel(i).reset();
             }
+            histories_.reset();
         }
         
-        void handleMpeActivation(Time t, ActiveChannel& channel, int range)
+        void handleMpeActivation(Ticks t, ActiveChannel& channel, int range)
         {
             // handle lower zone
             if (channel.number_ == 0)
@@ -426,7 +986,7 @@ namespace showmidi
                     // to the lower zone
                     for (int i = 1; i <= 14; ++i)
                     {
-                        auto& ch = channel_[i];
+                        auto& ch = writeChannel(i);
                         if (ch.mpeMember_ == MpeMember::mpeLower)
                         {
                             ch.mpeMember_ = MpeMember::mpeNone;
@@ -443,7 +1003,7 @@ namespace showmidi
                     // assign channels to the lower zone
                     for (int i = 1; i <= range; ++i)
                     {
-                        auto& ch = channel_[i];
+                        auto& ch = writeChannel(i);
                         ch.mpeMember_ = MpeMember::mpeLower;
                         ch.time_ = t;
                     }
@@ -455,7 +1015,7 @@ namespace showmidi
                     // upper zone, if it was enabled
                     if (range >= 14)
                     {
-                        auto& ch = channel_[15];
+                        auto& ch = writeChannel(15);
                         if (ch.mpeManager_)
                         {
                             ch.mpeManager_ = false;
@@ -475,7 +1035,7 @@ namespace showmidi
                     // to the upper zone
                     for (int i = 14; i >= 1; --i)
                     {
-                        auto& ch = channel_[i];
+                        auto& ch = writeChannel(i);
                         if (ch.mpeMember_ == MpeMember::mpeUpper)
                         {
                             ch.mpeMember_ = MpeMember::mpeNone;
@@ -492,7 +1052,7 @@ namespace showmidi
                     // assign channels to the upper zone
                     for (int i = 1; i <= range; ++i)
                     {
-                        auto& ch = channel_[15 - i];
+                        auto& ch = writeChannel(15 - i);
                         ch.mpeMember_ = MpeMember::mpeUpper;
                         ch.time_ = t;
                     }
@@ -504,7 +1064,7 @@ namespace showmidi
                     // lower zone, if it was enabled
                     if (range >= 14)
                     {
-                        auto& ch = channel_[0];
+                        auto& ch = writeChannel(0);
                         if (ch.mpeManager_)
                         {
                             ch.mpeManager_ = false;
@@ -515,5 +1075,17 @@ namespace showmidi
                 }
             }
         }
+        
+    private:
+        ActiveChannels(const ActiveChannels&) = default;
+        
+        void setGeneration(uint32 generation)
+        {
+            generation_ = generation;
+            histories_.setGeneration(generation);
+        }
+        
+        uint32 generation_ { 0 };
+        StatePage<ActiveChannel> channel_[16];
     };
 }
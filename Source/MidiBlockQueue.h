@@ -0,0 +1,141 @@
+/*
+ * This file is part of ShowMIDI.
+ * Copyright (command) 2023 Uwyn LLC.  https://www.uwyn.com
+ *
+ * ShowMIDI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ShowMIDI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "ChannelState.h"
+
+namespace showmidi
+{
+    // wait-free single-producer single-consumer queue of whole MidiBuffer
+    // blocks, the audio thread copies the raw bytes of a block in one go,
+    // without looking at its events, and the message thread takes them
+    // apart; the bytes are stored back to back in a preallocated ring
+    class MidiBlockQueue
+    {
+    public:
+        static constexpr int DEFAULT_CAPACITY = 64 * 1024;
+
+        MidiBlockQueue(int capacity = DEFAULT_CAPACITY) :
+            fifo_(capacity),
+            bytes_(size_t(capacity))
+        {
+        }
+
+        // producer side, the events of the block are timed from its start,
+        // returns false when the consumer fell behind and the whole block had
+        // to be dropped
+        bool push(Ticks start, double ticksPerSample, const MidiBuffer& buffer)
+        {
+            const auto size = buffer.data.size();
+            if (size == 0)
+            {
+                return true;
+            }
+
+            const BlockHeader header { start, ticksPerSample, size };
+            const auto total = int(sizeof(header)) + size;
+            if (fifo_.getFreeSpace() < total)
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            const auto scope = fifo_.write(total);
+            auto position = scope.startIndex1;
+            copyIn(position, &header, int(sizeof(header)));
+            copyIn(position, buffer.data.getRawDataPointer(), size);
+            return true;
+        }
+
+        // consumer side, calls the function with each queued block in order,
+        // rebuilt into the provided buffer
+        template <typename Function>
+        void drain(MidiBuffer& block, Function&& function)
+        {
+            const auto ready = fifo_.getNumReady();
+            if (ready == 0)
+            {
+                return;
+            }
+
+            // blocks are always published whole, so everything that's ready
+            // consists of complete blocks
+            const auto scope = fifo_.read(ready);
+            auto position = scope.startIndex1;
+            auto remaining = ready;
+            while (remaining >= int(sizeof(BlockHeader)))
+            {
+                BlockHeader header;
+                copyOut(position, &header, int(sizeof(header)));
+
+                block.clear();
+                block.data.resize(header.size_);
+                copyOut(position, block.data.getRawDataPointer(), header.size_);
+                remaining -= int(sizeof(header)) + header.size_;
+
+                function(header.start_, header.ticksPerSample_, static_cast<const MidiBuffer&>(block));
+            }
+        }
+
+        // consumer side, discards everything that's queued
+        void clear()
+        {
+            fifo_.read(fifo_.getNumReady());
+        }
+
+        // the number of blocks that didn't fit
+        int getNumDropped() const
+        {
+            return dropped_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct BlockHeader
+        {
+            Ticks start_;
+            double ticksPerSample_;
+            int size_;
+        };
+
+        // the reserved space is contiguous modulo the capacity, it only wraps
+        // around at the end of the ring
+        void copyIn(int& position, const void* source, int size)
+        {
+            const auto first = std::min(size, int(bytes_.size()) - position);
+            memcpy(bytes_.data() + position, source, size_t(first));
+            memcpy(bytes_.data(), static_cast<const uint8*>(source) + first, size_t(size - first));
+            position = (position + size) % int(bytes_.size());
+        }
+
+        void copyOut(int& position, void* destination, int size) const
+        {
+            const auto first = std::min(size, int(bytes_.size()) - position);
+            memcpy(destination, bytes_.data() + position, size_t(first));
+            memcpy(static_cast<uint8*>(destination) + first, bytes_.data(), size_t(size - first));
+            position = (position + size) % int(bytes_.size());
+        }
+
+        AbstractFifo fifo_;
+        std::vector<uint8> bytes_;
+        std::atomic<int> dropped_ { 0 };
+
+        JUCE_DECLARE_NON_COPYABLE (MidiBlockQueue)
+    };
+}
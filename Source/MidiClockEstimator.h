@@ -0,0 +1,187 @@
+/*
+ * This file is part of ShowMIDI.
+ * Copyright (command) 2023 Uwyn LLC.  https://www.uwyn.com
+ *
+ * ShowMIDI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ShowMIDI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace showmidi
+{
+    // estimates the tempo of a MIDI clock from the intervals between its
+    // latest ticks, which are kept in a fixed ring with a running sum, so
+    // that a tick never allocates
+    class MidiClockEstimator
+    {
+    public:
+        static constexpr int TIMESTAMP_WINDOW = 48;
+        static constexpr int MAX_INTERVALS = TIMESTAMP_WINDOW - 1;
+        static constexpr double BPM_MIN = 20.0;
+        static constexpr double BPM_MAX = 360.0;
+
+        MidiClockEstimator()
+        {
+            reset();
+        }
+
+        void reset()
+        {
+            hasLastTick_ = false;
+            lastTick_ = 0.0;
+            next_ = 0;
+            count_ = 0;
+            sum_ = 0.0;
+            numConsistent_ = 0;
+            bpm_ = 0.0;
+            jitterMs_ = 0.0;
+            driftPpm_ = 0.0;
+        }
+
+        // adds the timestamp in seconds of a clock tick, returns true when
+        // enough consistent intervals were seen to provide a tempo reading
+        bool addTick(double timeStamp)
+        {
+            if (hasLastTick_)
+            {
+                auto interval = fabs(timeStamp - lastTick_);
+                if (count_ == MAX_INTERVALS)
+                {
+                    sum_ -= intervals_[next_];
+                }
+                else
+                {
+                    ++count_;
+                }
+                intervals_[next_] = interval;
+                sum_ += interval;
+                next_ = (next_ + 1) % MAX_INTERVALS;
+
+                // the running sum is recomputed once per lap of the ring, so
+                // that rounding errors can't pile up
+                if (next_ == 0)
+                {
+                    sum_ = 0.0;
+                    for (auto i = 0; i < count_; ++i)
+                    {
+                        sum_ += intervals_[i];
+                    }
+                }
+            }
+            hasLastTick_ = true;
+            lastTick_ = timeStamp;
+
+            numConsistent_ = 0;
+            if (count_ == 0)
+            {
+                return false;
+            }
+
+            // the average across all intervals is used to filter out outliers,
+            // since stalled and burst-delivered ticks show up as outlier
+            // intervals that would otherwise swing the tempo around wildly
+            auto avg_interval = sum_ / count_;
+
+            // only intervals that are within 15% deviation of the average are
+            // consistent, which passes the millisecond quantization of senders
+            // but drops the stalls and the bursts of late-delivered ticks;
+            // this visits the intervals from oldest to newest, to also compare
+            // the older half of the window with the newer one
+            auto sum = 0.0;
+            auto sum_squares = 0.0;
+            auto older_sum = 0.0;
+            auto older_count = 0;
+            auto newer_sum = 0.0;
+            auto newer_count = 0;
+            for (auto i = 0; i < count_; ++i)
+            {
+                auto interval = intervals_[(next_ + MAX_INTERVALS - count_ + i) % MAX_INTERVALS];
+                if (fabs(avg_interval - interval) < avg_interval * 0.15)
+                {
+                    ++numConsistent_;
+                    sum += interval;
+                    sum_squares += interval * interval;
+                    if (i < count_ / 2)
+                    {
+                        older_sum += interval;
+                        ++older_count;
+                    }
+                    else
+                    {
+                        newer_sum += interval;
+                        ++newer_count;
+                    }
+                }
+            }
+
+            // with at least four consistent intervals, calculate the bpm
+            if (numConsistent_ <= 4)
+            {
+                return false;
+            }
+
+            auto mean = sum / numConsistent_;
+            bpm_ = int((600.0 / mean / 24.0) + 0.5) / 10.0;
+            bpm_ = std::min(std::max(bpm_, BPM_MIN), BPM_MAX);
+
+            // the spread of the consistent intervals and how much faster the
+            // newer half of the window ticks than the older half
+            jitterMs_ = sqrt(std::max(0.0, sum_squares / numConsistent_ - mean * mean)) * 1000.0;
+            driftPpm_ = 0.0;
+            if (older_count > 0 && newer_count > 0)
+            {
+                driftPpm_ = ((older_sum / older_count) / (newer_sum / newer_count) - 1.0) * 1000000.0;
+            }
+
+            // wait for a mostly full window: fewer intervals give a rough
+            // reading, while requiring even more starves the display at high
+            // tempos, where ticks are closer together and more of them get
+            // dropped above
+            return numConsistent_ >= TIMESTAMP_WINDOW * 3 / 4;
+        }
+
+        // the latest tempo reading, to a tenth of a BPM
+        double getBpm() const
+        {
+            return bpm_;
+        }
+
+        // the standard deviation of the consistent tick intervals
+        double getJitterMs() const
+        {
+            return jitterMs_;
+        }
+
+        // the tempo change across the window, positive when speeding up
+        double getDriftPpm() const
+        {
+            return driftPpm_;
+        }
+
+    private:
+        bool hasLastTick_;
+        double lastTick_;
+        double intervals_[MAX_INTERVALS];
+        int next_;
+        int count_;
+        double sum_;
+        int numConsistent_;
+        double bpm_;
+        double jitterMs_;
+        double driftPpm_;
+
+        JUCE_DECLARE_NON_COPYABLE (MidiClockEstimator)
+    };
+}
@@ -18,6 +18,9 @@
 #include "MidiDeviceComponent.h"
 
 #include "ChannelState.h"
+#include "MidiDeviceState.h"
+#include "OutputStrings.h"
+#include "TextCache.h"
 
 namespace showmidi
 {
@@ -34,7 +37,20 @@ namespace showmidi
             owner_(owner),
             settingsManager_(manager),
             theme_(manager->getSettings().getTheme()),
-            deviceInfo_({ name, ""})
+            deviceInfo_({ name, ""}),
+            ownState_(new MidiDeviceState(manager->getSettings())),
+            state_(*ownState_)
+        {
+        }
+        
+        // the state is owned and kept up to date by someone else, like the
+        // audio processor of the plugin, this is only a view of it
+        Pimpl(MidiDeviceComponent* owner, SettingsManager* manager, const String& name, MidiDeviceState& state) :
+            owner_(owner),
+            settingsManager_(manager),
+            theme_(manager->getSettings().getTheme()),
+            deviceInfo_({ name, ""}),
+            state_(state)
         {
         }
         
@@ -42,7 +58,9 @@ namespace showmidi
             owner_(owner),
             settingsManager_(manager),
             theme_(manager->getSettings().getTheme()),
-            deviceInfo_(info)
+            deviceInfo_(info),
+            ownState_(new MidiDeviceState(manager->getSettings())),
+            state_(*ownState_)
         {
             auto midi_input = MidiInput::openDevice(info.identifier, this);
             if (midi_input != nullptr)
@@ -57,11 +75,12 @@ namespace showmidi
         
         void showTestData()
         {
-            const auto t = Time::getCurrentTime();
+            const auto t = currentTicks();
+            auto& channels = state_.getChannels();
             
             deviceInfo_ = {"MIDI Instrument Name", deviceInfo_.identifier};
             
-            auto& sysex = channels_.sysex_;
+            auto& sysex = channels.sysex_;
             sysex.time_ = t;
             sysex.length_ = 0xC;
             uint8_t data[Sysex::MAX_SYSEX_DATA] = {
@@ -69,7 +88,7 @@ namespace showmidi
                 0x1, 0x2, 0xA, 0x7F, 0x0, 0xFE, 0x0, 0xAA, 0x1, 0x7E};
             memcpy(sysex.data_, data, Sysex::MAX_SYSEX_DATA);
 
-            auto& clock = channels_.clock_;
+            auto& clock = channels.clock_;
             clock.bpm_ = 111.0;
             clock.timeBpm_ = t;
             clock.spp_ = 4242;
@@ -78,502 +97,252 @@ namespace showmidi
             clock.timeContinue_ = t;
             clock.timeStop_ = t;
 
-            auto& channel1 = channels_.channel_[0];
+            auto& channel1 = channels.writeChannel(0);
             channel1.mpeManager_ = true;
             channel1.mpeMember_ = MpeMember::mpeLower;
             channel1.time_ = t;
-            channel1.programChange_.current_.value_ = 0;
-            channel1.programChange_.current_.time_ = t;
-            channel1.pitchBend_.current_.value_ = 9256;
-            channel1.pitchBend_.current_.time_ = t;
+            channel1.programChange_.value_[0] = 0;
+            channel1.programChange_.time_[0] = t;
+            channel1.pitchBend_.value_[0] = 9256;
+            channel1.pitchBend_.time_[0] = t;
             channel1.notes_.time_ = t;
-            channel1.notes_.noteOn_[61].current_.value_ = 127;
-            channel1.notes_.noteOn_[61].current_.time_ = t;
-            channel1.notes_.noteOn_[61].polyPressure_.current_.value_ = 0;
-            channel1.notes_.noteOn_[79].current_.value_ = 38;
-            channel1.notes_.noteOn_[79].current_.time_ = t;
-            channel1.notes_.noteOn_[79].polyPressure_.current_.value_ = 120;
-            channel1.notes_.noteOn_[79].polyPressure_.current_.time_ = t;
-            channel1.channelPressure_.current_.value_ = 76;
-            channel1.channelPressure_.current_.time_ = t;
+            channel1.notes_.active_.add(61);
+            channel1.notes_.active_.add(79);
+            channel1.notes_.on_.value_[61] = 127;
+            channel1.notes_.on_.time_[61] = t;
+            channel1.notes_.polyPressure_.value_[61] = 0;
+            channel1.notes_.on_.value_[79] = 38;
+            channel1.notes_.on_.time_[79] = t;
+            channel1.notes_.polyPressure_.value_[79] = 120;
+            channel1.notes_.polyPressure_.time_[79] = t;
+            channel1.channelPressure_.value_[0] = 76;
+            channel1.channelPressure_.time_[0] = t;
             channel1.controlChanges_.time_ = t;
-            channel1.controlChanges_.controlChange_[74].current_.value_ = 127;
-            channel1.controlChanges_.controlChange_[74].current_.time_ = t;
-            auto& cc74_history = channel1.controlChanges_.controlChange_[74].history_;
-            auto cc74_t = t.toMilliseconds();
-            cc74_history.push_back({Time(cc74_t -= 100), 100});
-            cc74_history.push_back({Time(cc74_t -= 100), 99});
-            cc74_history.push_back({Time(cc74_t -= 100), 95});
-            cc74_history.push_back({Time(cc74_t -= 700), 90});
-            cc74_history.push_back({Time(cc74_t -= 1000), 80});
-            cc74_history.push_back({Time(cc74_t -= 3000), 30});
-            channel1.controlChanges_.controlChange_[7].current_.value_ = 64;
-            channel1.controlChanges_.controlChange_[7].current_.time_ = Time(t.toMilliseconds() - 500);
-            channel1.controlChanges_.controlChange_[39].current_.value_ = 32;
-            channel1.controlChanges_.controlChange_[39].current_.time_ = t;
+            channel1.controlChanges_.active_.add(7);
+            channel1.controlChanges_.active_.add(39);
+            channel1.controlChanges_.active_.add(74);
+            auto cc74 = channel1.controlChanges_.controlChange_.ref(74);
+            cc74.value_ = 127;
+            cc74.time_ = t;
+            auto cc74_history = channels.histories_.acquire(cc74.history_, cc74.owner_, t);
+            auto cc74_t = t;
+            cc74_history->addOldest({cc74_t -= 100 * TICKS_PER_MS, 100});
+            cc74_history->addOldest({cc74_t -= 100 * TICKS_PER_MS, 99});
+            cc74_history->addOldest({cc74_t -= 100 * TICKS_PER_MS, 95});
+            cc74_history->addOldest({cc74_t -= 700 * TICKS_PER_MS, 90});
+            cc74_history->addOldest({cc74_t -= 1000 * TICKS_PER_MS, 80});
+            cc74_history->addOldest({cc74_t -= 3000 * TICKS_PER_MS, 30});
+            channel1.controlChanges_.controlChange_.value_[7] = 64;
+            channel1.controlChanges_.controlChange_.time_[7] = t - 500 * TICKS_PER_MS;
+            channel1.controlChanges_.controlChange_.value_[39] = 32;
+            channel1.controlChanges_.controlChange_.time_[39] = t;
             channel1.rpns_.time_ = t;
-            channel1.rpns_.param_[0].current_.time_ = t;
-            channel1.rpns_.param_[0].current_.value_ = (96 << 7) + 50;
-            channel1.rpns_.param_[1].current_.time_ = t;
-            channel1.rpns_.param_[1].current_.value_ = (127 << 7) + 127;
-            channel1.rpns_.param_[2].current_.time_ = t;
-            channel1.rpns_.param_[2].current_.value_ = (127 << 7) + 127;
-            channel1.rpns_.param_[6].current_.time_ = t;
-            channel1.rpns_.param_[6].current_.value_ = 10;
+            channel1.rpns_.param_[0].time_ = t;
+            channel1.rpns_.param_[0].value_ = (96 << 7) + 50;
+            channel1.rpns_.param_[1].time_ = t;
+            channel1.rpns_.param_[1].value_ = (127 << 7) + 127;
+            channel1.rpns_.param_[2].time_ = t;
+            channel1.rpns_.param_[2].value_ = (127 << 7) + 127;
+            channel1.rpns_.param_[6].time_ = t;
+            channel1.rpns_.param_[6].value_ = 10;
             channel1.hrccs_.time_ = t;
-            channel1.hrccs_.param_[7].current_.time_ = t;
-            channel1.hrccs_.param_[7].current_.value_ = 64 << 7 | 32 ;
+            channel1.hrccs_.param_[7].time_ = t;
+            channel1.hrccs_.param_[7].value_ = 64 << 7 | 32 ;
             
-            auto& channel16 = channels_.channel_[15];
+            auto& channel16 = channels.writeChannel(15);
             channel16.time_ = t;
-            channel16.programChange_.current_.value_ = 127;
-            channel16.programChange_.current_.time_ = t;
-            channel16.pitchBend_.current_.value_ = 0;
-            channel16.pitchBend_.current_.time_ = t;
+            channel16.programChange_.value_[0] = 127;
+            channel16.programChange_.time_[0] = t;
+            channel16.pitchBend_.value_[0] = 0;
+            channel16.pitchBend_.time_[0] = t;
             channel16.notes_.time_ = t;
-            channel16.notes_.noteOn_[61].current_.value_ = 127;
-            channel16.notes_.noteOn_[61].current_.time_ = t;
-            channel16.notes_.noteOn_[61].polyPressure_.current_.value_ = 73;
-            channel16.notes_.noteOn_[61].polyPressure_.current_.time_ = t;
-            channel16.notes_.noteOn_[79].current_.value_ = 127;
-            channel16.notes_.noteOn_[79].current_.time_ = t;
-            channel16.notes_.noteOn_[79].polyPressure_.current_.value_ = 0;
-            channel16.notes_.noteOff_[79].current_.value_ = 127;
-            channel16.notes_.noteOff_[79].current_.time_ = t;
-            channel16.channelPressure_.current_.value_ = 76;
-            channel16.channelPressure_.current_.time_ = t;
+            channel16.notes_.active_.add(61);
+            channel16.notes_.active_.add(79);
+            channel16.notes_.on_.value_[61] = 127;
+            channel16.notes_.on_.time_[61] = t;
+            channel16.notes_.polyPressure_.value_[61] = 73;
+            channel16.notes_.polyPressure_.time_[61] = t;
+            channel16.notes_.on_.value_[79] = 127;
+            channel16.notes_.on_.time_[79] = t;
+            channel16.notes_.polyPressure_.value_[79] = 0;
+            channel16.notes_.off_.value_[79] = 127;
+            channel16.notes_.off_.time_[79] = t;
+            channel16.channelPressure_.value_[0] = 76;
+            channel16.channelPressure_.time_[0] = t;
             channel16.controlChanges_.time_ = t;
-            channel16.controlChanges_.controlChange_[1].current_.value_ = 124;
-            channel16.controlChanges_.controlChange_[1].current_.time_ = t;
-            channel16.controlChanges_.controlChange_[45].current_.value_ = 89;
-            channel16.controlChanges_.controlChange_[45].current_.time_ = t;
-            channel16.controlChanges_.controlChange_[127].current_.value_ = 100;
-            channel16.controlChanges_.controlChange_[127].current_.time_ = t;
+            channel16.controlChanges_.active_.add(1);
+            channel16.controlChanges_.active_.add(45);
+            channel16.controlChanges_.active_.add(127);
+            channel16.controlChanges_.controlChange_.value_[1] = 124;
+            channel16.controlChanges_.controlChange_.time_[1] = t;
+            channel16.controlChanges_.controlChange_.value_[45] = 89;
+            channel16.controlChanges_.controlChange_.time_[45] = t;
+            channel16.controlChanges_.controlChange_.value_[127] = 100;
+            channel16.controlChanges_.controlChange_.time_[127] = t;
         }
         
         ~Pimpl()
         {
             midiIn_ = nullptr;
+            state_.detachView(view_);
         }
         
         void handleIncomingMidiMessage(MidiInput*, const MidiMessage& msg)
         {
-            const auto t = Time::getCurrentTime();
-            lastActivityMillis_ = t.toMilliseconds();
+            // messages are stamped on arrival: MidiInput stamps them with the
+            // 32-bit Time::getMillisecondCounter(), which wraps after about
+            // 49.7 days and can come from another clock than the ticks
+            const auto t = currentTicks();
+            
+            // the MIDI thread only queues the message, the channel state is
+            // exclusively updated on the message thread, which never blocks
+            // the MIDI thread behind painting
+            state_.getQueue().push(t, msg);
+        }
+        
+        // the ticks only convert to wall clock time for display
+        Time getLastActivityTime() const
+        {
+            return Time(Time::currentTimeMillis() - (currentTicks() - state_.getLastActivity()) / TICKS_PER_MS);
+        }
+        
+        void render()
+        {
+            const auto t = currentTicks();
+            
+            state_.update(t);
             
-            if (msg.isSysEx())
+            auto dirty = dirtySections_ | state_.takeDirtySections(view_);
+            dirtySections_ = 0;
+            
+            // changes to the display settings require everything to be painted again
+            auto settings = getDisplaySettings();
+            if (settings != displaySettings_)
             {
-                auto& sysex = channels_.sysex_;
-                sysex.time_ = t;
-                sysex.length_ = msg.getSysExDataSize();
-                memset(sysex.data_, 0, Sysex::MAX_SYSEX_DATA);
-                memcpy(sysex.data_, msg.getSysExData(), std::min(msg.getSysExDataSize(), Sysex::MAX_SYSEX_DATA));
-                dirty_ = true;
-                return;
+                displaySettings_ = settings;
+                dirty |= DIRTY_ALL;
             }
             
-            if (msg.isMidiClock())
+            // while paused, the snapshot that's shown doesn't change; while
+            // live, sections also change when what they show expires and
+            // graphs scroll by a column every render time unit
+            if (paused_)
             {
-                auto ts_secs = msg.getTimeStamp();
-                
-                // keep a queue of MIDI clock timestamps, never exceeding TIMESTAMP_QUEUE_SIZE
-                midiTimeStamps_.push_front(ts_secs);
-                while (midiTimeStamps_.size() > TIMESTAMP_QUEUE_SIZE)
+                dirty &= DIRTY_ALL;
+            }
+            else
+            {
+                if (t >= headerExpiry_)
                 {
-                    midiTimeStamps_.pop_back();
+                    dirty |= DIRTY_ALL;
                 }
                 
-                // calculate the average across the intervals between the queued timestamps
-                // this will be used to filter out outliers, since stalled and
-                // burst-delivered ticks show up as outlier intervals that would
-                // otherwise swing the tempo around wildly
-                std::vector<double> intervals;
-                for (auto i = 0; i + 1 < midiTimeStamps_.size(); i++)
+                auto scroll = t - lastScroll_ >= RENDER_TIME_UNIT_TICKS;
+                if (scroll)
                 {
-                    intervals.push_back(fabs(midiTimeStamps_[i] - midiTimeStamps_[i + 1]));
+                    lastScroll_ = t;
                 }
-
-                auto avg_interval = 0.0;
-                for (auto i = 0; i < intervals.size(); i++)
-                {
-                    avg_interval += intervals[i];
-                }
-                if (intervals.size() > 0)
-                {
-                    avg_interval /= intervals.size();
-                }
-
-                // only keep intervals that are within 15% deviation of the average,
-                // which passes the millisecond quantization of senders but drops
-                // the stalls and the bursts of late-delivered ticks
-                std::vector<double> keep;
-                for (auto i = 0; i < intervals.size(); i++)
-                {
-                    if (fabs(avg_interval - intervals[i]) < avg_interval * 0.15)
-                    {
-                        keep.push_back(intervals[i]);
-                    }
-                }
-
-                // if we have at least four valid intervals, calculate the bpm
-                if (keep.size() > 4)
+                
+                for (auto i = 0; i < 16; ++i)
                 {
-                    auto sum = 0.0;
-                    for (auto i = 0; i < keep.size(); i++)
+                    auto& layout = channelLayout_[i];
+                    if (t >= layout.expiry_)
                     {
-                        sum += keep[i];
+                        dirty |= uint64(1) << (16 + i);
                     }
-                    sum /= keep.size();
-                    
-                    auto bpm = int((600.0 / sum / 24.0) + 0.5) / 10.0;
-                    bpm = std::min(std::max(bpm, BPM_MIN), BPM_MAX);
-
-                    // wait for a mostly full window: fewer intervals give a
-                    // rough reading, while requiring even more starves the
-                    // display at high tempos, where ticks are closer together
-                    // and more of them get dropped above
-                    if (keep.size() >= TIMESTAMP_QUEUE_SIZE * 3 / 4)
+                    if (scroll && layout.animated_)
                     {
-                        auto& clock = channels_.clock_;
-
-                        // single readings wobble, so a running average smooths
-                        // them; after a tempo jump the average starts from a
-                        // single reading that may round to the wrong number,
-                        // and while it disagrees with the display it catches
-                        // up faster, calming down again once they match
-                        auto avg_dt = ts_secs - midiClockAvgTime_;
-                        if (midiClockAvgTime_ <= 0.0 || avg_dt > 2.0)
-                        {
-                            midiClockAvgBpm_ = bpm;
-                        }
-                        else
-                        {
-                            auto correcting = ts_secs - midiClockJumpTime_ < 1.5
-                                              && fabs(midiClockAvgBpm_ - clock.bpm_) >= 0.35;
-                            midiClockAvgBpm_ += std::min(1.0, avg_dt / (correcting ? 0.35 : 1.0)) * (bpm - midiClockAvgBpm_);
-                        }
-                        midiClockAvgTime_ = ts_secs;
-
-                        // only a big change counts as a tempo jump, since the
-                        // wobble at high tempos can span a few BPM; small real
-                        // changes reach the display through the average anyway
-                        if (fabs(bpm - clock.bpm_) >= std::max(4.0, bpm * 0.03))
-                        {
-                            midiClockAvgBpm_ = bpm;
-                            midiClockJumpTime_ = ts_secs;
-                        }
-
-                        // keep the readout alive while the clock is running
-                        if ((t - clock.timeBpm_).inSeconds() > 0.5)
-                        {
-                            clock.timeBpm_ = t;
-                        }
-
-                        // the tempo is shown as a whole BPM: MIDI clock only
-                        // carries 24 pulses per beat and the receive timing
-                        // jitters, so the reading isn't trustworthy below about
-                        // a whole BPM anyway. The average has to clearly cross
-                        // over to another value before the display follows, and
-                        // a step to the next number has to stick around for a
-                        // moment first, while a move of several BPM shows
-                        // immediately
-                        if (fabs(midiClockAvgBpm_ - clock.bpm_) < 0.75)
-                        {
-                            midiClockCrossingSince_ = 0.0;
-                        }
-                        else
-                        {
-                            auto target = double(int(midiClockAvgBpm_ + 0.5));
-                            auto neighbour = fabs(target - clock.bpm_) < 2.0;
-                            if (neighbour && midiClockCrossingSince_ <= 0.0)
-                            {
-                                midiClockCrossingSince_ = ts_secs;
-                            }
-                            else if (!neighbour || ts_secs - midiClockCrossingSince_ >= 0.6)
-                            {
-                                midiClockCrossingSince_ = 0.0;
-                                clock.bpm_ = target;
-                                dirty_ = true;
-                            }
-                        }
+                        dirty |= uint64(1) << i;
                     }
                 }
-                return;
             }
-            else if (msg.isMidiStart())
-            {
-                channels_.clock_.timeStart_ = t;
-                midiTimeStamps_.clear();
-                midiClockAvgTime_ = 0.0;
-                return;
-            }
-            else if (msg.isMidiContinue())
-            {
-                channels_.clock_.timeContinue_ = t;
-                midiTimeStamps_.clear();
-                midiClockAvgTime_ = 0.0;
-                return;
-            }
-            else if (msg.isMidiStop())
-            {
-                channels_.clock_.timeStop_ = t;
-                midiTimeStamps_.clear();
-                midiClockAvgTime_ = 0.0;
-                return;
-            }
-            else if (msg.isSongPositionPointer())
+            
+            invalidate(dirty);
+        }
+        
+        // repaints the sections that are dirty, based on where the channels
+        // were in the last paint
+        void invalidate(uint64 dirty)
+        {
+            if (dirty == 0)
             {
-                channels_.clock_.timeSpp_ = t;
-                channels_.clock_.spp_ = msg.getSongPositionPointerMidiBeat();
-                dirty_ = true;
                 return;
             }
-
-            if (msg.getChannel() <= 0)
+            
+            if ((dirty & DIRTY_ALL) != 0)
             {
+                owner_->repaint();
                 return;
             }
             
-            ChannelMessage* channel_message = nullptr;
+            auto width = owner_->getWidth();
+            auto height = owner_->getHeight();
             
-            auto& channel = channels_.channel_[msg.getChannel() - 1];
-            if (msg.isNoteOn())
+            if ((dirty & DIRTY_CLOCK) != 0)
             {
-                auto& notes = channel.notes_;
-                notes.time_ = t;
-                
-                auto& note_off = notes.noteOff_[msg.getNoteNumber()];
-                note_off.current_.time_ = Time();
-
-                auto& note_on = notes.noteOn_[msg.getNoteNumber()];
-                note_on.current_.value_ = msg.getVelocity();
-                channel_message = &note_on;
-            }
-            else if (msg.isNoteOff())
-            {
-                auto& notes = channel.notes_;
-                notes.time_ = t;
-                
-                auto& note_off = notes.noteOff_[msg.getNoteNumber()];
-                note_off.current_.value_ = msg.getVelocity();
-                channel_message = &note_off;
+                owner_->repaint(0, clockTop_, width, sysexTop_ - clockTop_);
             }
-            else if (msg.isAftertouch())
+            if ((dirty & DIRTY_SYSEX) != 0)
             {
-                auto& notes = channel.notes_;
-                notes.time_ = t;
-                
-                auto& note_on = notes.noteOn_[msg.getNoteNumber()];
-                channel_message = &note_on.polyPressure_;
-                collectHistory(channel_message);
-                channel_message->current_.value_ = msg.getAfterTouchValue();
+                owner_->repaint(0, sysexTop_, width, channelsTop_ - sysexTop_);
             }
-            else if (msg.isController())
+            
+            // a layout change moves everything below it, a channel that isn't
+            // shown yet is inserted above the others
+            auto layout_top = height;
+            for (auto i = 0; i < 16; ++i)
             {
-                auto& control_changes = channel.controlChanges_;
-                control_changes.time_ = t;
-                
-                auto number = msg.getControllerNumber();
-                auto value = msg.getControllerValue();
-                
-                switch (number)
+                auto& layout = channelLayout_[i];
+                auto changed_layout = (dirty & (uint64(1) << (16 + i))) != 0;
+                auto changed_values = (dirty & ((uint64(1) << i) | (uint64(1) << (DIRTY_NOTES_SHIFT + i)))) != 0;
+                if (changed_layout || (changed_values && layout.top_ < 0))
                 {
-                    case 98:
-                        channel.lastNrpnLsb_ = value;
-                        break;
-                    case 99:
-                        channel.lastNrpnMsb_ = value;
-                        break;
-                    case 100:
-                        channel.lastRpnLsb_ = value;
-                        // resetting RPN numbers also resets NRPN numbers
-                        if (channel.lastRpnLsb_ == 127 && channel.lastRpnMsb_ == 127)
-                        {
-                            channel.lastNrpnLsb_ = 127;
-                            channel.lastNrpnMsb_ = 127;
-                        }
-                        break;
-                    case 101:
-                        channel.lastRpnMsb_ = value;
-                        break;
-                    default:
-                        // Support for 14-bit high resolution control changes as per MIDI 1.0 Detailed Specification v4.2.1:
-                        // 1. both MSB and LSB need to be transmitted initially
-                        // 2. subsequent fine adjustment can use only the LSB value and reuse the previous MSB value
-                        // 3. subsequent major adjustment must retransmit MSB, upon MSB reception the concept of LSB should be set to 0
-                        // Additional personal interpretations:
-                        // 4. for bullet 3: LSB is only set to 0 when MSB value is different
-                        // 5. for bullet 3: if previous MSB value was lower, then LSB is 0, otherwise LSB is 127
-                        if (number >= 0 && number < 32)
-                        {
-                            auto msb_number = number;
-                            auto lsb_number = msb_number + 32;
-                            auto& msb_tv = control_changes.controlChange_[msb_number].current_;
-                            auto& lsb_tv = control_changes.controlChange_[lsb_number].current_;
-                            // see bullet 1 above
-                            if (msb_tv.time_.toMilliseconds() > 0 &&
-                                lsb_tv.time_.toMilliseconds() > 0)
-                            {
-                                // see bullet 4 above
-                                if (msb_tv.value_ != value)
-                                {
-                                    auto msb_value = value;
-                                    // see bullet 5 above
-                                    auto lsb_value = 0;
-                                    if (msb_tv.value_ > msb_value)
-                                    {
-                                        lsb_value = 127;
-                                    }
-                                    
-                                    // see bullets 3, 4, 5 above
-                                    handle14BitControlChangeValue(t, channel, msb_number, msb_value, lsb_value);
-                                }
-                            }
-                            // we also handle the data entry control change for NRPN and RPN here
-                            // since it can potentially be used only as MSB data entry only
-                            else if (number == 6)
-                            {
-                                handleDataEntryControlChange(t, channel, value, 0);
-                            }
-                        }
-                        else if (number >= 32 && number < 64)
-                        {
-                            auto msb_number = number - 32;
-                            auto& msb_tv = control_changes.controlChange_[msb_number].current_;
-                            // see bullet 1 above
-                            if (msb_tv.time_.toMilliseconds() > 0)
-                            {
-                                // see bullet 2 above
-                                auto msb_value = msb_tv.value_;
-                                auto lsb_value = value;
-                                handle14BitControlChangeValue(t, channel, msb_number, msb_value, lsb_value);
-                            }
-                        }
-                        break;
+                    layout_top = std::min(layout_top, layout.top_ < 0 ? channelsTop_ : layout.top_);
                 }
-                
-                channel_message = &control_changes.controlChange_[number];
-                collectHistory(channel_message);
-                channel_message->current_.value_ = value;
-            }
-            else if (msg.isProgramChange())
-            {
-                channel_message = &channel.programChange_;
-                channel_message->current_.value_ = msg.getProgramChangeNumber();
             }
-            else if (msg.isChannelPressure())
+            if (layout_top < height)
             {
-                channel_message = &channel.channelPressure_;
-                collectHistory(channel_message);
-                channel_message->current_.value_ = msg.getChannelPressureValue();
-            }
-            else if (msg.isPitchWheel())
-            {
-                channel_message = &channel.pitchBend_;
-                collectHistory(channel_message);
-                channel_message->current_.value_ = msg.getPitchWheelValue();
-            }
-            
-            if (channel_message != nullptr)
-            {
-                channel_message->current_.time_ = t;
-                channel.time_ = t;
-                dirty_ = true;
-            }
-        }
-
-        void handle14BitControlChangeValue(const Time& t, ActiveChannel& channel, int number, int msbValue, int lsbValue)
-        {
-            auto was_rpn_or_nrpn = false;
-            // handle RPN or NRPN
-            if (number == 6)
-            {
-                was_rpn_or_nrpn = handleDataEntryControlChange(t, channel, msbValue, lsbValue);
+                owner_->repaint(0, layout_top, width, height - layout_top);
             }
             
-            // handle Hi-Res Control Change
-            if (!was_rpn_or_nrpn)
+            // changed notes only repaint the notes area of their channel
+            for (auto i = 0; i < 16; ++i)
             {
-                const std::lock_guard<std::mutex> lock(paramsLock_);
-                
-                auto& hrcc = channel.hrccs_;
-                collectHistory(&hrcc.param_[number]);
-                
-                hrcc.time_ = t;
-                hrcc.param_[number].current_.time_ = t;
-                // see bullet 2 above
-                hrcc.param_[number].current_.value_ = (msbValue << 7) + lsbValue;
-            }
-        }
-        
-        bool handleDataEntryControlChange(const Time& t, ActiveChannel& channel, int msbValue, int lsbValue)
-        {
-            const std::lock_guard<std::mutex> lock(paramsLock_);
-            
-            if (channel.lastRpnMsb_ != 127 || channel.lastRpnLsb_ != 127)
-            {
-                auto rpn_number = (channel.lastRpnMsb_ << 7) + channel.lastRpnLsb_;
-                auto rpn_value = (msbValue << 7) + lsbValue;
-                auto& rpns = channel.rpns_;
-                collectHistory(&rpns.param_[rpn_number]);
-                
-                rpns.time_ = t;
-                rpns.param_[rpn_number].current_.time_ = t;
-                rpns.param_[rpn_number].current_.value_ = rpn_value;
-                
-                // handle MPE activation message
-                if (rpn_number == 6 && msbValue <= 0xf)
+                auto& layout = channelLayout_[i];
+                if (layout.top_ < 0 || layout.top_ >= layout_top)
                 {
-                    channels_.handleMpeActivation(t, channel, msbValue);
+                    continue;
                 }
                 
-                return true;
-            }
-            // handle NRPN
-            else if (channel.lastNrpnMsb_ != 127 || channel.lastNrpnLsb_ != 127)
-            {
-                auto nrpn_number = (channel.lastNrpnMsb_ << 7) + channel.lastNrpnLsb_;
-                auto nrpn_value = (msbValue << 7) + lsbValue;
-                auto& nrpns = channel.nrpns_;
-                collectHistory(&nrpns.param_[nrpn_number]);
-                
-                nrpns.time_ = t;
-                nrpns.param_[nrpn_number].current_.time_ = t;
-                nrpns.param_[nrpn_number].current_.value_ = nrpn_value;
-                
-                return true;
-            }
-            
-            return false;
-        }
-
-        void collectHistory(ChannelMessage* message)
-        {
-            if (message->current_.time_.toMilliseconds() > 0)
-            {
-                const std::lock_guard<std::mutex> lock(historyLock_);
-                message->history_.insert(message->history_.begin(), message->current_);
+                auto changed_notes = (dirty & (uint64(1) << (DIRTY_NOTES_SHIFT + i))) != 0;
+                if ((dirty & (uint64(1) << i)) != 0 || (changed_notes && layout.notesHeight_ <= 0))
+                {
+                    owner_->repaint(0, layout.top_, width, layout.height_);
+                }
+                else if (changed_notes)
+                {
+                    owner_->repaint(0, layout.notesTop_, X_MID, layout.notesHeight_);
+                }
             }
         }
         
-        void render()
+        int64 getDisplaySettings()
         {
-            const auto t = Time::getCurrentTime();
-            
-            bool expected = true;
-            if (dirty_.compare_exchange_strong(expected, false) || (t - lastRender_).inMilliseconds() >= RENDER_TIME_UNIT_MS)
-            {
-                lastRender_ = t;
-                owner_->repaint();
-            }
+            auto& settings = settingsManager_->getSettings();
+            return (int64(settings.getTimeoutDelay()) << 32) |
+                   (int64(settings.getControlGraphHeight()) << 16) |
+                   (int64(settings.getOctaveMiddleC() & 0xff) << 8) |
+                   (int64(settings.getVisualization()) << 4) |
+                   (int64(settings.getNoteFormat()) << 2) |
+                   int64(settings.getNumberFormat());
         }
         
-        static constexpr int RENDER_TIME_UNIT_MS = 50;
+        static constexpr uint64 DIRTY_ALL = MidiDeviceState::DIRTY_ALL;
+        static constexpr uint64 DIRTY_CLOCK = MidiDeviceState::DIRTY_CLOCK;
+        static constexpr uint64 DIRTY_SYSEX = MidiDeviceState::DIRTY_SYSEX;
+        static constexpr int DIRTY_NOTES_SHIFT = MidiDeviceState::DIRTY_NOTES_SHIFT;
+        static constexpr Ticks NEVER_EXPIRES = std::numeric_limits<Ticks>::max();
         
-        static constexpr int TIMESTAMP_QUEUE_SIZE = 48;
-        static constexpr double BPM_MIN = 20.0;
-        static constexpr double BPM_MAX = 360.0;
-
         static constexpr int STANDARD_WIDTH = 254;
         static constexpr int X_MID = 151;
         
@@ -609,6 +378,10 @@ namespace showmidi
         
         static constexpr int HEIGHT_INDICATOR = 1;
         
+        // the newest columns of a graph can still change with late messages,
+        // they're painted again whenever the graph scrolls or its value changes
+        static constexpr int REPAINTED_GRAPH_COLUMNS = 2;
+        
         static constexpr int X_PB = 84;
         static constexpr int Y_PB = 7;
         static constexpr int X_PB_DATA = 24;
@@ -630,18 +403,61 @@ namespace showmidi
         static constexpr int Y_CC = 7;
         static constexpr int X_CC_DATA = 24;
         
+        static_assert(STANDARD_WIDTH - X_PB - X_PB_DATA <= MAX_GRAPH_WIDTH &&
+                      STANDARD_WIDTH - X_PARAM - X_PARAM_DATA <= MAX_GRAPH_WIDTH &&
+                      STANDARD_WIDTH - X_CC - X_CC_DATA <= MAX_GRAPH_WIDTH &&
+                      X_PP_DATA - X_PP <= MAX_GRAPH_WIDTH, "graphs can't be wider than the history they show");
+        
         struct ChannelPaintState
         {
-            Time time_;
+            Ticks time_ { 0 };
             int offset_ { 0 };
+            const HistoryPool* histories_ { nullptr };
+            Ticks expiry_ { NEVER_EXPIRES };
+            bool animated_ { false };
+        };
+        
+        // the backing image of a graph, which scrolls along with the graph
+        // columns so that only the newest columns are painted again, with
+        // what it was painted with to know when it has to be painted anew
+        struct GraphImage
+        {
+            Image image_;
+            int64 column_ { 0 };
+            Ticks newest_ { 0 };
+            Ticks used_ { 0 };
+            int scale_ { 0 };
+            int centerValue_ { 0 };
+            int maxValue_ { 0 };
+            bool bidirectional_ { false };
+            Colour colourPositive_;
+            Colour colourNegative_;
+            Colour colourTrack_;
+            Colour colourSeperator_;
+        };
+        
+        // where a channel and its notes were painted, when the first of the
+        // messages it shows expires and whether it has graphs that scroll
+        struct ChannelLayout
+        {
+            int top_ { -1 };
+            int height_ { 0 };
+            int notesTop_ { 0 };
+            int notesHeight_ { 0 };
+            Ticks expiry_ { NEVER_EXPIRES };
+            bool animated_ { false };
         };
         
         void paint(Graphics& g)
         {
             g.fillAll(theme_.colorBackground);
             
-            auto t = Time::getCurrentTime();
-            auto channels = &channels_;
+            auto& settings = settingsManager_->getSettings();
+            strings_.update(settings.getNumberFormat(), settings.getNoteFormat(), settings.getOctaveMiddleC());
+            
+            auto t = currentTicks();
+            paintTime_ = t;
+            const ActiveChannels* channels = &state_.getChannels();
             if (paused_)
             {
                 t = pausedTime_;
@@ -649,7 +465,7 @@ namespace showmidi
             }
             
             // draw the data for each channel
-            ChannelPaintState state = { t, 0 };
+            ChannelPaintState state = { t, 0, &channels->histories_ };
             
             // draw MIDI port name
             auto port_name = deviceInfo_.name;
@@ -659,22 +475,27 @@ namespace showmidi
             }
             g.setFont(theme_.fontLabel());
             g.setColour(theme_.colorData);
-            g.drawText(port_name,
+            drawText(g, port_name,
                        X_PORT, Y_PORT,
                        owner_->getWidth(), theme_.labelHeight(),
                        Justification::centredLeft);
             
             state.offset_ = Y_PORT + theme_.labelHeight();
             
+            clockTop_ = state.offset_;
             paintClock(g, state, channels->clock_);
 
-            if (!isExpired(t, channels->sysex_.time_)) {
+            sysexTop_ = state.offset_;
+            if (isShown(state, channels->sysex_.time_)) {
                 paintSysex(g, state, channels->sysex_);
             }
             
+            headerExpiry_ = state.expiry_;
+            channelsTop_ = state.offset_;
+            
             for (auto channel_index = 0; channel_index < 16; ++channel_index)
             {
-                auto& channel_messages = channels->channel_[channel_index];
+                auto& channel_messages = channels->channel(channel_index);
                 if (isExpired(t, channel_messages.time_))
                 {
                     auto existing = std::find(channelOrder_.begin(), channelOrder_.end(), channel_index);
@@ -682,6 +503,7 @@ namespace showmidi
                     {
                         channelOrder_.erase(existing);
                     }
+                    channelLayout_[channel_index] = ChannelLayout();
                 }
                 else {
                     auto existing = std::find(channelOrder_.begin(), channelOrder_.end(), channel_index);
@@ -690,15 +512,25 @@ namespace showmidi
                         channelOrder_.insert(channelOrder_.begin(), channel_index);
                     }
                 }
-                
-                pruneParameters(t, channel_messages.hrccs_);
-                pruneParameters(t, channel_messages.rpns_);
-                pruneParameters(t, channel_messages.nrpns_);
             }
 
             for (auto channel_index : channelOrder_)
             {
-                auto& channel_messages = channels->channel_[channel_index];
+                auto& channel_messages = channels->channel(channel_index);
+                
+                // a channel that didn't move and is outside of the area that's
+                // being painted is left as is
+                auto& layout = channelLayout_[channel_index];
+                auto top = state.offset_;
+                if (layout.top_ == top && !g.clipRegionIntersects(Rectangle<int>(0, top, owner_->getWidth(), layout.height_)))
+                {
+                    state.offset_ += layout.height_;
+                    continue;
+                }
+                
+                state.expiry_ = NEVER_EXPIRES;
+                state.animated_ = false;
+                isShown(state, channel_messages.time_);
                 
                 paintChannelHeader(g, state, channel_messages);
                 
@@ -707,31 +539,32 @@ namespace showmidi
                 state.offset_ = paintParameters(g, state, PARAM_HRCC, channel_messages.hrccs_);
                 state.offset_ = paintParameters(g, state, PARAM_RPN, channel_messages.rpns_);
                 state.offset_ = paintParameters(g, state, PARAM_NRPN, channel_messages.nrpns_);
+                int notes_top = state.offset_;
                 int notes_bottom = paintNotes(g, state, channel_messages);
                 int control_changes_bottom = paintControlChanges(g, state, channel_messages);
                 
                 state.offset_ = std::max(state.offset_, std::max(notes_bottom, control_changes_bottom));
                 
                 state.offset_ += Y_CHANNEL_MARGIN;
+                
+                layout = { top, state.offset_ - top,
+                           notes_top, std::max(0, notes_bottom - notes_top),
+                           state.expiry_, state.animated_ };
             }
                         
             lastHeight_ = state.offset_;
-        }
-        
-        void pruneParameters(Time t, Parameters& params)
-        {
-            const std::lock_guard<std::mutex> lock(paramsLock_);
             
-            auto it_param = params.param_.begin();
-            while (it_param != params.param_.end())
+            // graphs that weren't painted for as long as they're wide would
+            // be painted anew anyway, their images are dropped
+            for (auto it = graphImages_.begin(); it != graphImages_.end();)
             {
-                if (isExpired(t, it_param->second.current_.time_))
+                if (paintTime_ - it->second.used_ > MAX_GRAPH_WIDTH * RENDER_TIME_UNIT_TICKS)
                 {
-                    it_param = params.param_.erase(it_param);
+                    it = graphImages_.erase(it);
                 }
                 else
                 {
-                    ++it_param;
+                    ++it;
                 }
             }
         }
@@ -746,13 +579,13 @@ namespace showmidi
             return lastHeight_;
         }
         
-        void paintClock(Graphics& g, ChannelPaintState& state, Clock& clock)
+        void paintClock(Graphics& g, ChannelPaintState& state, const Clock& clock)
         {
-            auto show_bpm = !isExpired(state.time_, clock.timeBpm_);
-            auto show_spp = !isExpired(state.time_, clock.timeSpp_);
-            auto show_start = !isExpired(state.time_, clock.timeStart_);
-            auto show_continue = !isExpired(state.time_, clock.timeContinue_);
-            auto show_stop = !isExpired(state.time_, clock.timeStop_);
+            auto show_bpm = isShown(state, clock.timeBpm_);
+            auto show_spp = isShown(state, clock.timeSpp_);
+            auto show_start = isShown(state, clock.timeStart_);
+            auto show_continue = isShown(state, clock.timeContinue_);
+            auto show_stop = isShown(state, clock.timeStop_);
             auto show_transport = show_start || show_continue || show_stop;
             auto show_clock = show_bpm || show_spp || show_transport;
             if (!show_clock)
@@ -768,7 +601,7 @@ namespace showmidi
             
             g.setColour(theme_.colorData);
             g.setFont(theme_.fontLabel());
-            g.drawText(String("CLOCK"),
+            drawText(g, String("CLOCK"),
                        X_CLOCK, state.offset_,
                        getStandardWidth() - X_CLOCK, theme_.labelHeight(),
                        Justification::centredLeft);
@@ -778,14 +611,14 @@ namespace showmidi
             {
                 g.setColour(theme_.colorController);
                 g.setFont(theme_.fontLabel());
-                g.drawText("BPM",
+                drawText(g, "BPM",
                            X_PARAM, state.offset_,
                            clock_width, theme_.labelHeight(),
                            Justification::centredLeft);
                 
                 g.setColour(theme_.colorData);
                 g.setFont(theme_.fontData());
-                g.drawText(outputBpm(clock.bpm_),
+                drawText(g, outputBpm(clock.bpm_),
                            X_PARAM, state.offset_,
                            clock_width, theme_.dataHeight(),
                            Justification::centredRight);
@@ -799,14 +632,14 @@ namespace showmidi
             {
                 g.setColour(theme_.colorController);
                 g.setFont(theme_.fontLabel());
-                g.drawText("SPP",
+                drawText(g, "SPP",
                            X_PARAM, state.offset_,
                            clock_width, theme_.labelHeight(),
                            Justification::centredLeft);
 
                 g.setColour(theme_.colorData);
                 g.setFont(theme_.fontData());
-                g.drawText(outputSongPosition(clock.spp_),
+                drawText(g, outputSongPosition(clock.spp_),
                            X_PARAM, state.offset_,
                            clock_width, theme_.dataHeight(),
                            Justification::centredRight);
@@ -822,7 +655,7 @@ namespace showmidi
                 {
                     g.setColour(theme_.colorPositive);
                     g.setFont(theme_.fontLabel());
-                    g.drawText("START",
+                    drawText(g, "START",
                                X_PARAM, state.offset_,
                                clock_width, theme_.labelHeight(),
                                Justification::centredLeft);
@@ -832,7 +665,7 @@ namespace showmidi
                 {
                     g.setColour(theme_.colorPositive);
                     g.setFont(theme_.fontLabel());
-                    g.drawText("CONT",
+                    drawText(g, "CONT",
                                X_PARAM, state.offset_,
                                clock_width, theme_.labelHeight(),
                                Justification::centred);
@@ -842,7 +675,7 @@ namespace showmidi
                 {
                     g.setColour(theme_.colorNegative);
                     g.setFont(theme_.fontLabel());
-                    g.drawText("STOP",
+                    drawText(g, "STOP",
                                X_PARAM, state.offset_,
                                clock_width, theme_.dataHeight(),
                                Justification::centredRight);
@@ -860,7 +693,7 @@ namespace showmidi
             state.offset_ += HEIGHT_SEPERATOR + Y_CLOCK_PADDING;
         }
 
-        void paintSysex(Graphics& g, ChannelPaintState& state, Sysex& sysex)
+        void paintSysex(Graphics& g, ChannelPaintState& state, const Sysex& sysex)
         {
             state.offset_ += Y_SYSEX;
             
@@ -869,14 +702,14 @@ namespace showmidi
             // draw syxex header and length
             g.setColour(theme_.colorData);
             g.setFont(theme_.fontLabel());
-            g.drawText(String("SYSEX"),
+            drawText(g, String("SYSEX"),
                        X_SYSEX, state.offset_,
                        getStandardWidth() - X_SYSEX, theme_.labelHeight(),
                        Justification::centredLeft);
             
             g.setColour(theme_.colorLabel);
             g.setFont(theme_.fontLabel());
-            g.drawText(output14Bit(sysex.length_),
+            drawText(g, output14Bit(sysex.length_),
                        X_SYSEX, state.offset_,
                        sysex_width, theme_.dataHeight(),
                        Justification::centredRight);
@@ -895,7 +728,7 @@ namespace showmidi
                 
                 data_x = X_SYSEX_DATA;
                 for (; i < i_row && i < sysex.length_; ++i) {
-                    g.drawText(output7Bit(sysex.data_[i]),
+                    drawText(g, output7Bit(sysex.data_[i]),
                                data_x, state.offset_,
                                X_SYSEX_DATA_WIDTH, theme_.dataHeight(),
                                Justification::centredRight);
@@ -914,12 +747,12 @@ namespace showmidi
             state.offset_ += HEIGHT_SEPERATOR + Y_SYSEX_PADDING;
         }
         
-        void paintChannelHeader(Graphics& g, ChannelPaintState& state, ActiveChannel& channel)
+        void paintChannelHeader(Graphics& g, ChannelPaintState& state, const ActiveChannel& channel)
         {
             g.setColour(theme_.colorData);
             g.setFont(theme_.fontLabel());
             state.offset_ += Y_CHANNEL;
-            g.drawText(String("CH ") + output7Bit(channel.number_ + 1),
+            drawText(g, strings_.channel(channel.number_),
                        X_CHANNEL, state.offset_,
                        getStandardWidth() - X_CHANNEL, theme_.labelHeight(),
                        Justification::centredLeft);
@@ -927,7 +760,7 @@ namespace showmidi
             if (channel.mpeMember_ != MpeMember::mpeNone)
             {
                 g.setColour(theme_.colorLabel);
-                g.drawText("MPE",
+                drawText(g, "MPE",
                            X_CHANNEL_MPE, state.offset_,
                            getStandardWidth() - X_CHANNEL_MPE, theme_.labelHeight(),
                            Justification::centredLeft);
@@ -946,7 +779,7 @@ namespace showmidi
                     mpe_label = "UZ";
                 }
                 g.setColour(theme_.colorLabel);
-                g.drawText(mpe_label,
+                drawText(g, mpe_label,
                            X_CHANNEL_MPE_TYPE, state.offset_,
                            getStandardWidth() - X_CHANNEL_MPE, theme_.labelHeight(),
                            Justification::centredLeft);
@@ -960,37 +793,37 @@ namespace showmidi
             state.offset_ += HEIGHT_SEPERATOR + Y_CHANNEL_PADDING;
         }
         
-        void paintProgramChange(Graphics& g, ChannelPaintState& state, ActiveChannel& channel)
+        void paintProgramChange(Graphics& g, ChannelPaintState& state, const ActiveChannel& channel)
         {
             auto& program_change = channel.programChange_;
-            if (!isExpired(state.time_, program_change.current_.time_))
+            if (isShown(state, program_change.time_[0]))
             {
                 // write the texts
                 
                 g.setColour(theme_.colorLabel);
                 g.setFont(theme_.fontLabel());
-                g.drawText(String("PRGM ") + output7Bit(program_change.current_.value_),
+                drawText(g, strings_.programChange(program_change.value_[0]),
                            0, state.offset_ - Y_CHANNEL_PADDING - Y_SEPERATOR - HEIGHT_SEPERATOR - theme_.labelHeight(),
                            getStandardWidth() - X_PRGM, theme_.labelHeight(),
                            Justification::centredRight);
             }
         }
         
-        int paintPitchBend(Graphics& g, ChannelPaintState& state, ActiveChannel& channel)
+        int paintPitchBend(Graphics& g, ChannelPaintState& state, const ActiveChannel& channel)
         {
             int y_offset = state.offset_;
             
-            auto& pitch_bend = channel.pitchBend_;
-            if (!isExpired(state.time_, pitch_bend.current_.time_))
+            auto pitch_bend = channel.pitchBend_.view(0);
+            if (isShown(state, pitch_bend.time_))
             {
                 y_offset += Y_PB;
                 
                 Colour pb_color = theme_.colorLabel;
-                if (pitch_bend.current_.value_ > 0x2000)
+                if (pitch_bend.value_ > 0x2000)
                 {
                     pb_color = theme_.colorPositive;
                 }
-                else if (pitch_bend.current_.value_ < 0x2000)
+                else if (pitch_bend.value_ < 0x2000)
                 {
                     pb_color = theme_.colorNegative;
                 }
@@ -1001,14 +834,14 @@ namespace showmidi
                 
                 g.setColour(pb_color);
                 g.setFont(theme_.fontLabel());
-                g.drawText("PB",
+                drawText(g, strings_.labelPitchBend_,
                            X_PB, y_offset,
                            pb_width, theme_.labelHeight(),
                            Justification::centredLeft);
                 
                 g.setColour(theme_.colorData);
                 g.setFont(theme_.fontData());
-                g.drawText(output14Bit(pitch_bend.current_.value_),
+                drawText(g, output14Bit(pitch_bend.value_),
                            X_PB, y_offset,
                            pb_width, theme_.dataHeight(),
                            Justification::centredRight);
@@ -1027,17 +860,17 @@ namespace showmidi
             return y_offset;
         }
         
-        int paintParameters(Graphics& g, ChannelPaintState& state, ParamType type, Parameters& parameters)
+        int paintParameters(Graphics& g, ChannelPaintState& state, ParamType type, const Parameters& parameters)
         {
             int y_offset = state.offset_;
 
-            if (!isExpired(state.time_, parameters.time_))
+            if (isShown(state, parameters.time_))
             {
-                const std::lock_guard<std::mutex> lock(paramsLock_);
-                
-                for (auto& [number, param] : parameters.param_)
+                for (auto index = 0; index < parameters.param_.size(); ++index)
                 {
-                    if (!isExpired(state.time_, param.current_.time_))
+                    auto number = parameters.param_.numberAt(index);
+                    auto& param = *parameters.param_.find(number);
+                    if (isShown(state, param.time_))
                     {
                         y_offset += Y_PARAM;
                         
@@ -1054,7 +887,7 @@ namespace showmidi
                             case PARAM_RPN: name = "RPN"; break;
                             case PARAM_NRPN: name = "NRPN"; break;
                         }
-                        g.drawText(name + String(" ") + output14Bit(number),
+                        drawText(g, name + String(" ") + output14Bit(number),
                                    X_PARAM, y_offset,
                                    param_width, theme_.labelHeight(),
                                    Justification::centredLeft);
@@ -1066,24 +899,24 @@ namespace showmidi
                         auto colourPositive = theme_.colorController;
                         auto colourNegative = theme_.colorController;
                         auto bidirectional = false;
-                        auto param_text = output14Bit(param.current_.value_);
+                        auto param_text = output14Bit(param.value_);
                         // handle standard RPN numbers and provide meaningful output for them
                         if (type == PARAM_RPN)
                         {
-                            auto msb_only = (param.current_.value_ >> 7) & 0x7F;
+                            auto msb_only = (param.value_ >> 7) & 0x7F;
                             if (number == 0)
                             {
                                 auto param_cents = String();
-                                auto cents = param.current_.value_ & 0x7f;
+                                auto cents = param.value_ & 0x7f;
                                 if (cents > 0)
                                 {
-                                    param_cents = String(" ") + String(param.current_.value_ & 0x7F);
+                                    param_cents = String(" ") + String(param.value_ & 0x7F);
                                 }
                                 param_text = String("PB SNS ") + String(msb_only) + param_cents;
                             }
                             else if (number == 1)
                             {
-                                param_text = String("FTUN ") + String(((param.current_.value_ - 8192) * 100.0) / 8192.0, 2);
+                                param_text = String("FTUN ") + String(((param.value_ - 8192) * 100.0) / 8192.0, 2);
                                 bidirectional = true;
                                 colourPositive = theme_.colorPositive;
                                 colourNegative = theme_.colorNegative;
@@ -1105,7 +938,7 @@ namespace showmidi
                             }
                             else if (number == 6 && msb_only <= 0xF)
                             {
-                                if (param.current_.value_ == 0)
+                                if (param.value_ == 0)
                                 {
                                     param_text = String("MPE OFF");
                                 }
@@ -1116,7 +949,7 @@ namespace showmidi
                             }
                         }
 
-                        g.drawText(param_text,
+                        drawText(g, param_text,
                                    X_PARAM, y_offset,
                                    param_width, theme_.dataHeight(),
                                    Justification::centredRight);
@@ -1125,7 +958,7 @@ namespace showmidi
                         
                         // draw value indicator
 
-                        paintVisualization(g, state, y_offset, param, 0x2000, 0x3FFF,
+                        paintVisualization(g, state, y_offset, parameters.view(number), 0x2000, 0x3FFF,
                                            bidirectional, colourPositive, colourNegative,
                                            X_PARAM, y_offset,
                                            param_width, HEIGHT_INDICATOR + (Y_PARAM + theme_.labelHeight() + HEIGHT_INDICATOR) * std::max(2, settingsManager_->getSettings().getControlGraphHeight()));
@@ -1136,30 +969,22 @@ namespace showmidi
             return y_offset;
         }
 
-        int paintNotes(Graphics& g, ChannelPaintState& state, ActiveChannel& channel)
+        int paintNotes(Graphics& g, ChannelPaintState& state, const ActiveChannel& channel)
         {
             int y_offset = -1;
             
             auto& notes = channel.notes_;
-            if (!isExpired(state.time_, notes.time_))
+            if (isShown(state, notes.time_))
             {
-                for (int i = 0; i < 128; ++i)
+                // only the notes that had activity are visited
+                for (int a = 0; a < notes.active_.size(); ++a)
                 {
-                    auto& note_on = notes.noteOn_[i];
-                    auto& note_off = notes.noteOff_[i];
-                    
-                    auto note_on_expired = isExpired(state.time_, note_on.current_.time_);
-                    auto note_off_expired = isExpired(state.time_, note_off.current_.time_);
-                    auto polypressure_expired = isExpired(state.time_, note_on.polyPressure_.current_.time_);
+                    auto i = notes.active_[a];
+                    auto note_on_expired = !isShown(state, notes.on_.time_[i]);
+                    auto note_off_expired = !isShown(state, notes.off_.time_[i]);
+                    auto polypressure_expired = !isShown(state, notes.polyPressure_.time_[i]);
                     if (!note_on_expired || !polypressure_expired)
                     {
-                        if (!note_on_expired && note_off_expired)
-                        {
-                            channel.time_ = state.time_;
-                            note_on.current_.time_ = state.time_;
-                            notes.time_ = state.time_;
-                        }
-                        
                         if (y_offset == -1)
                         {
                             y_offset = state.offset_;
@@ -1169,10 +994,10 @@ namespace showmidi
                         
                         // draw note text
                         
-                        auto note_color = !isExpired(state.time_, note_off.current_.time_) ? theme_.colorNegative : theme_.colorPositive;
+                        auto note_color = !note_off_expired ? theme_.colorNegative : theme_.colorPositive;
                         g.setColour(note_color);
                         g.setFont(theme_.fontLabel());
-                        g.drawText(outputNote(i),
+                        drawText(g, strings_.note(i),
                                    X_NOTE, y_offset,
                                    X_NOTE_DATA - X_NOTE, theme_.labelHeight(),
                                    Justification::centredLeft);
@@ -1182,14 +1007,14 @@ namespace showmidi
                             int note_width = X_NOTE_DATA - X_ON_OFF;
                             g.setColour(theme_.colorLabel);
                             g.setFont(theme_.fontLabel());
-                            g.drawText("ON",
+                            drawText(g, strings_.labelOn_,
                                        X_ON_OFF, y_offset,
                                        note_width, theme_.labelHeight(),
                                        Justification::centredLeft);
                             
                             g.setColour(theme_.colorData);
                             g.setFont(theme_.fontData());
-                            g.drawText(output7Bit(note_on.current_.value_),
+                            drawText(g, output7Bit(notes.on_.value_[i]),
                                        X_ON_OFF, y_offset,
                                        note_width, theme_.dataHeight(),
                                        Justification::centredRight);
@@ -1206,7 +1031,7 @@ namespace showmidi
                             
                             g.setColour(velocity_color);
                             g.fillRect(X_ON_OFF, y_offset,
-                                       (note_width * note_on.current_.value_) / 127, HEIGHT_INDICATOR);
+                                       (note_width * notes.on_.value_[i]) / 127, HEIGHT_INDICATOR);
                             
                             y_offset += HEIGHT_INDICATOR;
                         }
@@ -1223,14 +1048,14 @@ namespace showmidi
                             int pp_width = X_PP_DATA - X_PP;
                             g.setColour(theme_.colorLabel);
                             g.setFont(theme_.fontLabel());
-                            g.drawText("PP",
+                            drawText(g, strings_.labelPolyPressure_,
                                        X_PP, y_offset,
                                        pp_width, theme_.labelHeight(),
                                        Justification::centredLeft);
                             
                             g.setColour(theme_.colorData);
                             g.setFont(theme_.fontData());
-                            g.drawText(output7Bit(note_on.polyPressure_.current_.value_),
+                            drawText(g, output7Bit(notes.polyPressure_.value_[i]),
                                        X_PP, y_offset,
                                        pp_width, theme_.dataHeight(),
                                        Justification::centredRight);
@@ -1239,7 +1064,7 @@ namespace showmidi
                             
                             // draw polypressure indicator
                             
-                            paintVisualization(g, state, y_offset, note_on.polyPressure_, 0x40, 0x7f,
+                            paintVisualization(g, state, y_offset, notes.polyPressure_.view(i), 0x40, 0x7f,
                                                false, note_color, note_color,
                                                X_PP, y_offset,
                                                pp_width, HEIGHT_INDICATOR + (Y_PP + theme_.labelHeight() + HEIGHT_INDICATOR) * settingsManager_->getSettings().getControlGraphHeight());
@@ -1247,7 +1072,7 @@ namespace showmidi
                         }
                     }
                     
-                    if (!isExpired(state.time_, note_off.current_.time_))
+                    if (!note_off_expired)
                     {
                         if (y_offset == -1)
                         {
@@ -1260,11 +1085,11 @@ namespace showmidi
                         
                         auto note_color = theme_.colorNegative;
 
-                        if (isExpired(state.time_, note_on.current_.time_))
+                        if (note_on_expired)
                         {
                             g.setColour(note_color);
                             g.setFont(theme_.fontLabel());
-                            g.drawText(outputNote(i),
+                            drawText(g, strings_.note(i),
                                        X_NOTE, y_offset,
                                        X_NOTE_DATA - X_NOTE, theme_.labelHeight(),
                                        Justification::centredLeft);
@@ -1273,14 +1098,14 @@ namespace showmidi
                         int note_width = X_NOTE_DATA - X_ON_OFF;
                         g.setColour(theme_.colorLabel);
                         g.setFont(theme_.fontLabel());
-                        g.drawText("OFF",
+                        drawText(g, strings_.labelOff_,
                                    X_ON_OFF, y_offset,
                                    note_width, theme_.labelHeight(),
                                    Justification::centredLeft);
                         
                         g.setColour(theme_.colorData);
                         g.setFont(theme_.fontData());
-                        g.drawText(output7Bit(note_off.current_.value_),
+                        drawText(g, output7Bit(notes.off_.value_[i]),
                                    X_ON_OFF, y_offset,
                                    note_width, theme_.dataHeight(),
                                    Justification::centredRight);
@@ -1297,7 +1122,7 @@ namespace showmidi
 
                         g.setColour(velocity_color);
                         g.fillRect(X_ON_OFF, y_offset,
-                                   (note_width * note_off.current_.value_) / 127, HEIGHT_INDICATOR);
+                                   (note_width * notes.off_.value_[i]) / 127, HEIGHT_INDICATOR);
                         
                         y_offset += HEIGHT_INDICATOR;
                     }
@@ -1307,32 +1132,34 @@ namespace showmidi
             return y_offset;
         }
         
-        int paintControlChanges(Graphics& g, ChannelPaintState& state, ActiveChannel& channel)
+        int paintControlChanges(Graphics& g, ChannelPaintState& state, const ActiveChannel& channel)
         {
             int y_offset = -1;
             
-            if (!isExpired(state.time_, channel.channelPressure_.current_.time_))
+            if (isShown(state, channel.channelPressure_.time_[0]))
             {
-                paintControlChangeEntry(g, state, y_offset, String("CP"), channel.channelPressure_);
+                paintControlChangeEntry(g, state, y_offset, strings_.labelChannelPressure_, channel.channelPressure_.view(0));
             }
             
             auto& control_changes = channel.controlChanges_;
-            if (!isExpired(state.time_, control_changes.time_))
+            if (isShown(state, control_changes.time_))
             {
-                for (int i = 0; i < 128; ++i)
+                for (int a = 0; a < control_changes.active_.size(); ++a)
                 {
-                    auto& cc = control_changes.controlChange_[i];
-                    if (!isExpired(state.time_, cc.current_.time_))
+                    auto i = control_changes.active_[a];
+                    if (!isShown(state, control_changes.controlChange_.time_[i]))
                     {
-                        paintControlChangeEntry(g, state, y_offset, String("CC ") + output7Bit(cc.number_), cc);
+                        continue;
                     }
+                    
+                    paintControlChangeEntry(g, state, y_offset, strings_.controlChange(i), control_changes.controlChange_.view(i));
                 }
             }
             
             return y_offset;
         }
         
-        void paintControlChangeEntry(Graphics& g, ChannelPaintState& state, int& yOffset, const String& label, ChannelMessage& message)
+        void paintControlChangeEntry(Graphics& g, ChannelPaintState& state, int& yOffset, const String& label, const MessageView& message)
         {
             if (yOffset == -1)
             {
@@ -1346,14 +1173,14 @@ namespace showmidi
             int cc_width = getStandardWidth() - X_CC - X_CC_DATA;
             g.setColour(theme_.colorController);
             g.setFont(theme_.fontLabel());
-            g.drawText(label,
+            drawText(g, label,
                        X_CC, yOffset,
                        cc_width, theme_.labelHeight(),
                        Justification::centredLeft);
             
             g.setColour(theme_.colorData);
             g.setFont(theme_.fontData());
-            g.drawText(output7Bit(message.current_.value_),
+            drawText(g, output7Bit(message.value_),
                        X_CC, yOffset,
                        cc_width, theme_.dataHeight(),
                        Justification::centredRight);
@@ -1368,24 +1195,12 @@ namespace showmidi
                                cc_width, HEIGHT_INDICATOR + (Y_CC + theme_.labelHeight() + HEIGHT_INDICATOR) * settingsManager_->getSettings().getControlGraphHeight());
         }
         
-        void paintVisualization(Graphics& g, ChannelPaintState& state, int& yOffset, ChannelMessage& message, int centerValue, int maxValue,
+        void paintVisualization(Graphics& g, ChannelPaintState& state, int& yOffset, const MessageView& message, int centerValue, int maxValue,
                                 bool bidirectional, Colour colourPositive, Colour colourNegative, int graphLeft, int graphTop, int graphWidth, int graphHeight)
         {
-            // purge expired history entries
-            const std::lock_guard<std::mutex> lock(historyLock_);
-            const int64 graph_t = ((state.time_.toMilliseconds() + RENDER_TIME_UNIT_MS) / RENDER_TIME_UNIT_MS) * RENDER_TIME_UNIT_MS;
-            const int64 graph_expire = graph_t - graphWidth * RENDER_TIME_UNIT_MS - RENDER_TIME_UNIT_MS;
-            TimedValue last;
-            while (!message.history_.empty() && message.history_.back().time_.toMilliseconds() < graph_expire)
-            {
-                last = message.history_.back();
-                message.history_.pop_back();
-            }
-            if ((!message.history_.empty() && last.time_.toMilliseconds() != 0 && message.history_.back().time_.toMilliseconds() - graph_expire >= RENDER_TIME_UNIT_MS) ||
-                (message.history_.empty() && last.time_.toMilliseconds() != 0 && message.current_.time_.toMilliseconds() - graph_expire >= RENDER_TIME_UNIT_MS))
-            {
-                message.history_.push_back({Time(graph_expire), last.value_});
-            }
+            // history values from before the left edge are clamped to it
+            const Ticks graph_t = ((state.time_ + RENDER_TIME_UNIT_TICKS) / RENDER_TIME_UNIT_TICKS) * RENDER_TIME_UNIT_TICKS;
+            auto history = state.histories_->find(message.history_, message.owner_);
 
             // draw bar
             if (settingsManager_->getSettings().getVisualization() == Visualization::visualizationBar)
@@ -1395,15 +1210,15 @@ namespace showmidi
                            graphWidth, HEIGHT_INDICATOR);
                 
                 int indicator_x = graphLeft;
-                int indicator_width = (graphWidth * message.current_.value_) / maxValue;
+                int indicator_width = (graphWidth * message.value_) / maxValue;
                 int indicator_range = graphWidth / 2;
                 if (bidirectional)
                 {
                     indicator_x = graphLeft + indicator_range + 1;
-                    indicator_width = (indicator_range * (message.current_.value_ - centerValue)) / centerValue;
+                    indicator_width = (indicator_range * (message.value_ - centerValue)) / centerValue;
                 }
 
-                if (message.current_.value_ >= centerValue)
+                if (message.value_ >= centerValue)
                 {
                     g.setColour(colourPositive);
                 }
@@ -1425,29 +1240,103 @@ namespace showmidi
             // draw graph
             else
             {
-                g.setColour(theme_.colorTrack);
-                g.fillRect(graphLeft, graphTop,
-                           graphWidth, graphHeight);
+                state.animated_ = true;
                 
-                auto graph_total_width = 0;
+                paintGraph(g, message, history, graph_t, centerValue, maxValue,
+                           bidirectional, colourPositive, colourNegative, graphLeft, graphTop, graphWidth, graphHeight);
                 
-                paintGraphEntry(g, message.current_, graph_t, graph_total_width, centerValue, maxValue,
-                                bidirectional, colourPositive, colourNegative, graphLeft, graphTop, graphWidth, graphHeight);
-                for (auto& tv : message.history_)
+                yOffset += graphHeight;
+            }
+        }
+        
+        // graphs are painted into their backing image, which is scrolled by
+        // the columns that passed since it was last painted, only the newest
+        // columns are painted again and the image is then drawn as a whole
+        void paintGraph(Graphics& g, const MessageView& message, const TimedValueHistory* history, Ticks graphT, int centerValue, int maxValue,
+                        bool bidirectional, Colour colourPositive, Colour colourNegative, int graphLeft, int graphTop, int graphWidth, int graphHeight)
+        {
+            // the image has whole pixels per column, at the scale of the display
+            auto scale = std::max(1, roundToInt(g.getInternalContext().getPhysicalPixelScaleFactor()));
+            
+            auto& graph = graphImages_[message.owner_];
+            graph.used_ = paintTime_;
+            
+            auto column = graphT / RENDER_TIME_UNIT_TICKS;
+            auto scrolled = column - graph.column_;
+            
+            // the newest columns can still change with messages that arrive
+            // late, a change further back than that needs a full repaint
+            auto changed = message.time_ != graph.newest_;
+            auto changed_before = changed && message.time_ < graphT - REPAINTED_GRAPH_COLUMNS * RENDER_TIME_UNIT_TICKS;
+            
+            auto repainted = graphWidth;
+            if (graph.image_.isNull() ||
+                graph.image_.getWidth() != graphWidth * scale || graph.image_.getHeight() != graphHeight * scale ||
+                graph.scale_ != scale || graph.centerValue_ != centerValue || graph.maxValue_ != maxValue ||
+                graph.bidirectional_ != bidirectional ||
+                graph.colourPositive_ != colourPositive || graph.colourNegative_ != colourNegative ||
+                graph.colourTrack_ != theme_.colorTrack || graph.colourSeperator_ != theme_.colorSeperator ||
+                scrolled < 0 || scrolled >= graphWidth || changed_before)
+            {
+                if (graph.image_.isNull() || graph.image_.getWidth() != graphWidth * scale || graph.image_.getHeight() != graphHeight * scale)
+                {
+                    graph.image_ = Image(Image::RGB, graphWidth * scale, graphHeight * scale, false);
+                }
+                graph.scale_ = scale;
+                graph.centerValue_ = centerValue;
+                graph.maxValue_ = maxValue;
+                graph.bidirectional_ = bidirectional;
+                graph.colourPositive_ = colourPositive;
+                graph.colourNegative_ = colourNegative;
+                graph.colourTrack_ = theme_.colorTrack;
+                graph.colourSeperator_ = theme_.colorSeperator;
+            }
+            else if (scrolled > 0 || changed)
+            {
+                repainted = std::min(graphWidth, int(scrolled) + REPAINTED_GRAPH_COLUMNS);
+                if (scrolled > 0)
                 {
-                    paintGraphEntry(g, tv, graph_t, graph_total_width, centerValue, maxValue,
-                                    bidirectional, colourPositive, colourNegative, graphLeft, graphTop, graphWidth, graphHeight);
+                    graph.image_.moveImageSection(0, 0, int(scrolled) * scale, 0, (graphWidth - int(scrolled)) * scale, graphHeight * scale);
                 }
+            }
+            else
+            {
+                repainted = 0;
+            }
+            
+            if (repainted > 0)
+            {
+                Graphics image_g(graph.image_);
+                image_g.addTransform(AffineTransform::scale(float(scale)));
                 
-                yOffset += graphHeight;
+                auto repainted_left = graphWidth - repainted;
+                image_g.setColour(theme_.colorTrack);
+                image_g.fillRect(repainted_left, 0,
+                                 repainted, graphHeight);
+                
+                auto graph_total_width = 0;
+                
+                paintGraphEntry(image_g, { message.time_, message.value_ }, graphT, graph_total_width, centerValue, maxValue,
+                                bidirectional, colourPositive, colourNegative, repainted_left, 0, repainted, graphHeight);
+                for (auto i = 0; history != nullptr && i < history->size() && graph_total_width < repainted; ++i)
+                {
+                    paintGraphEntry(image_g, (*history)[i], graphT, graph_total_width, centerValue, maxValue,
+                                    bidirectional, colourPositive, colourNegative, repainted_left, 0, repainted, graphHeight);
+                }
             }
+            graph.column_ = column;
+            graph.newest_ = message.time_;
+            
+            g.drawImage(graph.image_,
+                        graphLeft, graphTop, graphWidth, graphHeight,
+                        0, 0, graph.image_.getWidth(), graph.image_.getHeight());
         }
         
-        void paintGraphEntry(Graphics& g, TimedValue& tv, int64 graph_t, int& graphTotalWidth, int centerValue, int maxValue,
+        void paintGraphEntry(Graphics& g, const TimedValue& tv, Ticks graph_t, int& graphTotalWidth, int centerValue, int maxValue,
                              bool bidirectional, Colour colourPositive, Colour colourNegative, int graphLeft, int graphTop, int graphWidth, int graphHeight)
         {
             auto graph_right = graphLeft + graphWidth;
-            auto graph_entry_width = std::min(graphWidth - graphTotalWidth, int(graph_t - tv.time_.toMilliseconds()) / RENDER_TIME_UNIT_MS- graphTotalWidth);
+            auto graph_entry_width = std::min(graphWidth - graphTotalWidth, int((graph_t - tv.time_) / RENDER_TIME_UNIT_TICKS) - graphTotalWidth);
             if (graph_entry_width > 0)
             {
                 auto graph_entry_left = graph_right - graph_entry_width - graphTotalWidth;
@@ -1486,35 +1375,38 @@ namespace showmidi
             }
         }
         
-        bool isExpired(const Time& currentTime, Time& messageTime)
+        // whether a message is painted, keeping track of when the first of
+        // the painted messages expires
+        bool isShown(ChannelPaintState& state, Ticks messageTime)
         {
-            if (messageTime.toMilliseconds() == 0)
+            if (isExpired(state.time_, messageTime))
             {
-                return true;
+                return false;
             }
             auto delay = settingsManager_->getSettings().getTimeoutDelay();
-            if (delay == 0)
+            if (delay != 0)
             {
-                return false;
+                state.expiry_ = std::min(state.expiry_, messageTime + delay * TICKS_PER_SECOND + 1);
             }
-            return (currentTime - messageTime).inSeconds() > delay;
+            return true;
         }
         
-        String output7BitAsHex(int v)
+        bool isExpired(Ticks currentTime, Ticks messageTime) const
         {
-            return String::toHexString(v).paddedLeft('0', 2).toUpperCase() + "H";
+            return state_.isExpired(currentTime, messageTime);
         }
         
+        // the texts are laid out once and then drawn from the cache
+        void drawText(Graphics& g, const String& text, int x, int y, int width, int height, Justification justification)
+        {
+            texts_.draw(g, text, x, y, width, height, justification);
+        }
+        
+        // 7-bit values come from the prebuilt tables, which are up to date
+        // with the settings during painting
         String output7Bit(int v)
         {
-            if (settingsManager_->getSettings().getNumberFormat() == NumberFormat::formatHexadecimal)
-            {
-                return output7BitAsHex(v);
-            }
-            else
-            {
-                return String(v);
-            }
+            return strings_.value7Bit(v);
         }
         
         String output14BitAsHex(int v)
@@ -1534,19 +1426,6 @@ namespace showmidi
             }
         }
         
-        String outputNote(int noteNumber)
-        {
-            if (settingsManager_->getSettings().getNoteFormat() == NoteFormat::formatNumber)
-            {
-                return output7Bit(noteNumber);
-            }
-            else
-            {
-                auto octave = settingsManager_->getSettings().getOctaveMiddleC();
-                return MidiMessage::getMidiNoteName(noteNumber, true, true, octave);
-            }
-        }
-        
         String outputBpm(double bpm)
         {
             // the tempo readout is a whole BPM
@@ -1567,29 +1446,36 @@ namespace showmidi
 
         void resized()
         {
-            dirty_ = true;
+            dirtySections_ |= DIRTY_ALL;
+        }
+        
+        // only the name changes, what's shown and cached is kept
+        void setDeviceName(const String& name)
+        {
+            if (name != deviceInfo_.name)
+            {
+                deviceInfo_.name = name;
+                owner_->repaint();
+            }
         }
         
         void setPaused(bool paused)
         {
             if (paused)
             {
-                const std::lock_guard<std::mutex> lock1(paramsLock_);
-                const std::lock_guard<std::mutex> lock2(historyLock_);
-                pausedTime_ = Time::getCurrentTime();
-                pausedChannels_ = channels_;
+                pausedTime_ = currentTicks();
+                pausedChannels_ = state_.snapshot();
             }
             
-            dirty_ = true;
+            dirtySections_ |= DIRTY_ALL;
             paused_ = paused;
         }
         
         void resetChannelData()
         {
-            const std::lock_guard<std::mutex> lock1(paramsLock_);
-            const std::lock_guard<std::mutex> lock2(historyLock_);
-            channels_.reset();
-            pausedChannels_.reset();
+            state_.reset();
+            pausedChannels_ = state_.snapshot();
+            dirtySections_ |= DIRTY_ALL;
         }
         
         bool isInterestedInFileDrag(const StringArray& files)
@@ -1623,32 +1509,37 @@ namespace showmidi
         Theme& theme_;
         MidiDeviceInfo deviceInfo_;
         std::vector<int> channelOrder_;
+        std::unordered_map<uint32, GraphImage> graphImages_;
+        Ticks paintTime_ { 0 };
+        OutputStrings strings_;
+        TextCache texts_;
         std::unique_ptr<MidiInput> midiIn_;
-        std::atomic_bool dirty_ { true };
-        Time lastRender_;
-        // written by the MIDI thread, read by the message thread
-        std::atomic<int64> lastActivityMillis_ { Time::currentTimeMillis() };
+        std::unique_ptr<MidiDeviceState> ownState_;
+        MidiDeviceState& state_;
+        const int view_ { state_.attachView() };
+        // sections of the display that need to be painted again, on top of
+        // the ones that changed in the state, see MidiDeviceState::DIRTY_ALL
+        uint64 dirtySections_ { DIRTY_ALL };
+        Ticks lastScroll_ { 0 };
+        int64 displaySettings_ { 0 };
         bool paused_ { false };
         
-        ActiveChannels channels_;
-        std::deque<double> midiTimeStamps_;
-        double midiClockAvgBpm_ { 0.0 };
-        double midiClockAvgTime_ { 0.0 };
-        double midiClockJumpTime_ { 0.0 };
-        double midiClockCrossingSince_ { 0.0 };
-        std::mutex paramsLock_;
-        std::mutex historyLock_;
-        
-        Time pausedTime_;
+        Ticks pausedTime_ { 0 };
         ActiveChannels pausedChannels_;
         
         int lastHeight_ { 0 };
+        Ticks headerExpiry_ { NEVER_EXPIRES };
+        int clockTop_ { 0 };
+        int sysexTop_ { 0 };
+        int channelsTop_ { 0 };
+        ChannelLayout channelLayout_[16];
         
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Pimpl)
     };
     
     MidiDeviceComponent::MidiDeviceComponent(SettingsManager* manager, const String& name) : pimpl_(new Pimpl(this, manager, name)) {}
     MidiDeviceComponent::MidiDeviceComponent(SettingsManager* manager, const MidiDeviceInfo& info) : pimpl_(new Pimpl(this, manager, info)) {}
+    MidiDeviceComponent::MidiDeviceComponent(SettingsManager* manager, const String& name, MidiDeviceState& state) : pimpl_(new Pimpl(this, manager, name, state)) {}
     MidiDeviceComponent::~MidiDeviceComponent() = default;
 
     int MidiDeviceComponent::getStandardWidth()         { return Pimpl::getStandardWidth(); }
@@ -1659,9 +1550,10 @@ namespace showmidi
     void MidiDeviceComponent::resized()           { pimpl_->resized(); }
     void MidiDeviceComponent::setPaused(bool p)   { pimpl_->setPaused(p); }
     void MidiDeviceComponent::resetChannelData()  { pimpl_->resetChannelData(); }
+    void MidiDeviceComponent::setDeviceName(const String& n)  { pimpl_->setDeviceName(n); }
 
     void MidiDeviceComponent::handleIncomingMidiMessage(const MidiMessage& m)   { pimpl_->handleIncomingMidiMessage(nullptr, m); };
-    Time MidiDeviceComponent::getLastActivityTime() const                       { return Time(pimpl_->lastActivityMillis_.load()); };
+    Time MidiDeviceComponent::getLastActivityTime() const                       { return pimpl_->getLastActivityTime(); };
     bool MidiDeviceComponent::isInterestedInFileDrag(const StringArray& f)      { return pimpl_->isInterestedInFileDrag(f); }
     void MidiDeviceComponent::filesDropped(const StringArray& f, int x, int y)  { pimpl_->filesDropped(f, x, y); }
 }
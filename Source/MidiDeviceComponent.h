@@ -24,11 +24,14 @@
 
 namespace showmidi
 {
+    class MidiDeviceState;
+    
     class MidiDeviceComponent : public Component, public FileDragAndDropTarget
     {
     public:
         MidiDeviceComponent(SettingsManager*, const String&);
         MidiDeviceComponent(SettingsManager*, const MidiDeviceInfo&);
+        MidiDeviceComponent(SettingsManager*, const String&, MidiDeviceState&);
         ~MidiDeviceComponent() override;
         
         static int getStandardWidth();
@@ -39,6 +42,7 @@ namespace showmidi
         void resized() override;
         void setPaused(bool);
         void resetChannelData();
+        void setDeviceName(const String&);
 
         void handleIncomingMidiMessage(const MidiMessage&);
         Time getLastActivityTime() const;
@@ -0,0 +1,767 @@
+/*
+ * This file is part of ShowMIDI.
+ * Copyright (command) 2023 Uwyn LLC.  https://www.uwyn.com
+ *
+ * ShowMIDI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ShowMIDI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "MidiDeviceState.h"
+
+#include "MidiClockEstimator.h"
+#include "SessionCapture.h"
+
+namespace showmidi
+{
+    struct MidiDeviceState::Pimpl
+    {
+        // the host's tempo takes precedence over MIDI clock for this long
+        static constexpr Ticks HOST_TRANSPORT_HOLD = TICKS_PER_SECOND;
+        
+        // held notes are kept on display by moving their time along, which
+        // is done well within the shortest timeout delay
+        static constexpr Ticks HELD_NOTE_REFRESH = TICKS_PER_SECOND / 2;
+        
+        Pimpl(Settings& settings) : settings_(settings)
+        {
+        }
+        
+        // applies the queued MIDI and drops what has nothing left to show
+        void update(Ticks t)
+        {
+            midiQueue_.drain([this] (const MidiEvent& event) { handleMidiEvent(event); });
+            
+            sweepChannels(t);
+            
+            // histories that scrolled out of every graph go back to the pool
+            channels_.histories_.release(t - (MAX_GRAPH_WIDTH + 2) * RENDER_TIME_UNIT_TICKS);
+        }
+        
+        // the host's tempo is exact, so it's shown as is and MIDI clock ticks
+        // don't need to be estimated while it keeps coming
+        void updateHostTransport(Ticks t, double bpm, double ppq, bool playing)
+        {
+            auto& clock = channels_.clock_;
+            
+            if (bpm != clock.bpm_ || isExpired(t, clock.timeBpm_))
+            {
+                markHeaderDirty(DIRTY_CLOCK, isExpired(t, clock.timeBpm_));
+            }
+            clock.timeHost_ = t;
+            clock.timeBpm_ = t;
+            clock.bpm_ = bpm;
+            
+            if (playing != clock.playing_)
+            {
+                markHeaderDirty(DIRTY_CLOCK, isTransportExpired(t));
+                
+                // like MIDI clock, playing from the very start is a start and
+                // playing from anywhere else continues
+                if (!playing)
+                {
+                    clock.timeStop_ = t;
+                }
+                else if (ppq <= 0.0)
+                {
+                    clock.timeStart_ = t;
+                }
+                else
+                {
+                    clock.timeContinue_ = t;
+                }
+                clock.playing_ = playing;
+            }
+            
+            // the song position counts sixteenth notes, four per quarter note
+            if (playing)
+            {
+                auto spp = int(ppq * 4.0);
+                if (spp != clock.spp_ || isExpired(t, clock.timeSpp_))
+                {
+                    markHeaderDirty(DIRTY_CLOCK, isExpired(t, clock.timeSpp_));
+                }
+                clock.spp_ = spp;
+                clock.timeSpp_ = t;
+            }
+        }
+        
+        void reset()
+        {
+            midiQueue_.clear();
+            channels_.reset();
+            dirtySections_ |= DIRTY_ALL;
+        }
+        
+        // a restored capture replaces what was shown, without going through
+        // the decoding of the messages
+        void restoreCapture(Ticks t, const MemoryBlock& capture)
+        {
+            channels_.reset();
+            SessionCapture::read(capture.getData(), capture.getSize(), t, channels_);
+            lastActivity_ = t;
+            dirtySections_ |= DIRTY_ALL;
+        }
+        
+        // a state can be displayed by several views at once, like the
+        // editors of different plugin instances, each of them collects the
+        // changed sections separately
+        int attachView()
+        {
+            auto view = nextView_++;
+            views_[view] = DIRTY_ALL;
+            return view;
+        }
+        
+        void detachView(int view)
+        {
+            views_.erase(view);
+        }
+        
+        uint64 takeDirtySections(int view)
+        {
+            if (dirtySections_ != 0)
+            {
+                for (auto& v : views_)
+                {
+                    v.second |= dirtySections_;
+                }
+                dirtySections_ = 0;
+            }
+            
+            auto it = views_.find(view);
+            if (it == views_.end())
+            {
+                return 0;
+            }
+            auto dirty = it->second;
+            it->second = 0;
+            return dirty;
+        }
+        
+        void handleMidiEvent(const MidiEvent& event)
+        {
+            // activity is tracked as the queue is drained, which also covers
+            // queues that are filled by someone else
+            lastActivity_ = event.time_;
+            
+            if (event.sysex_)
+            {
+                auto& sysex = channels_.sysex_;
+                // the number of data rows follows the length
+                markHeaderDirty(DIRTY_SYSEX, isExpired(event.time_, sysex.time_) || event.length_ != sysex.length_);
+                sysex.time_ = event.time_;
+                sysex.length_ = event.length_;
+                memcpy(sysex.data_, event.data_, Sysex::MAX_SYSEX_DATA);
+                return;
+            }
+            
+            handleMidiMessage(event.time_, event.data_, event.length_);
+        }
+        
+        // decodes a channel or system real-time message straight from its
+        // bytes, with a single dispatch on the status byte
+        void handleMidiMessage(Ticks t, const uint8* data, int length)
+        {
+            if (length <= 0)
+            {
+                return;
+            }
+            
+            const auto status = data[0];
+            const auto data1 = length > 1 ? int(data[1]) : 0;
+            const auto data2 = length > 2 ? int(data[2]) : 0;
+            
+            switch (status)
+            {
+                case 0xf8:
+                    handleMidiClock(t);
+                    return;
+                case 0xfa:
+                    handleMidiTransport(t, channels_.clock_.timeStart_);
+                    return;
+                case 0xfb:
+                    handleMidiTransport(t, channels_.clock_.timeContinue_);
+                    return;
+                case 0xfc:
+                    handleMidiTransport(t, channels_.clock_.timeStop_);
+                    return;
+                case 0xf2:
+                    markHeaderDirty(DIRTY_CLOCK, isExpired(t, channels_.clock_.timeSpp_));
+                    channels_.clock_.timeSpp_ = t;
+                    channels_.clock_.spp_ = data1 | (data2 << 7);
+                    return;
+                default:
+                    break;
+            }
+            
+            // the other system messages aren't shown
+            if (status < 0x80 || status >= 0xf0)
+            {
+                return;
+            }
+            
+            Ticks* message_time = nullptr;
+            
+            auto& channel = channels_.writeChannel(status & 0x0f);
+            // the layout changes when a channel appears
+            auto layout = isExpired(t, channel.time_);
+            switch (status & 0xf0)
+            {
+                case 0x90:
+                {
+                    // a note on without velocity is a note off
+                    if (data2 == 0)
+                    {
+                        handleNoteOff(t, channel, data1, 0, message_time);
+                        break;
+                    }
+                    
+                    auto& notes = channel.notes_;
+                    notes.time_ = t;
+                    
+                    auto number = data1;
+                    notes.active_.add(number);
+                    // a new note on replaces the note off of the same note
+                    layout = layout || !isExpired(t, notes.off_.time_[number]);
+                    notes.off_.time_[number] = 0;
+                    notes.on_.value_[number] = int16(data2);
+                    message_time = &notes.on_.time_[number];
+                    break;
+                }
+                case 0x80:
+                {
+                    handleNoteOff(t, channel, data1, data2, message_time);
+                    break;
+                }
+                case 0xa0:
+                {
+                    auto& notes = channel.notes_;
+                    notes.time_ = t;
+                    
+                    auto number = data1;
+                    notes.active_.add(number);
+                    auto poly_pressure = notes.polyPressure_.ref(number);
+                    collectHistory(t, poly_pressure);
+                    poly_pressure.value_ = int16(data2);
+                    message_time = &poly_pressure.time_;
+                    break;
+                }
+                case 0xb0:
+                {
+                    auto& control_changes = channel.controlChanges_;
+                    control_changes.time_ = t;
+                
+                    auto number = data1;
+                    auto value = data2;
+                
+                    switch (number)
+                    {
+                        case 98:
+                            channel.lastNrpnLsb_ = value;
+                            break;
+                        case 99:
+                            channel.lastNrpnMsb_ = value;
+                            break;
+                        case 100:
+                            channel.lastRpnLsb_ = value;
+                            // resetting RPN numbers also resets NRPN numbers
+                            if (channel.lastRpnLsb_ == 127 && channel.lastRpnMsb_ == 127)
+                            {
+                                channel.lastNrpnLsb_ = 127;
+                                channel.lastNrpnMsb_ = 127;
+                            }
+                            break;
+                        case 101:
+                            channel.lastRpnMsb_ = value;
+                            break;
+                        default:
+                            // Support for 14-bit high resolution control changes as per MIDI 1.0 Detailed Specification v4.2.1:
+                            // 1. both MSB and LSB need to be transmitted initially
+                            // 2. subsequent fine adjustment can use only the LSB value and reuse the previous MSB value
+                            // 3. subsequent major adjustment must retransmit MSB, upon MSB reception the concept of LSB should be set to 0
+                            // Additional personal interpretations:
+                            // 4. for bullet 3: LSB is only set to 0 when MSB value is different
+                            // 5. for bullet 3: if previous MSB value was lower, then LSB is 0, otherwise LSB is 127
+                            if (number >= 0 && number < 32)
+                            {
+                                auto msb_number = number;
+                                auto lsb_number = msb_number + 32;
+                                auto& control_change = control_changes.controlChange_;
+                                // see bullet 1 above
+                                if (control_change.time_[msb_number] > 0 &&
+                                    control_change.time_[lsb_number] > 0)
+                                {
+                                    // see bullet 4 above
+                                    if (control_change.value_[msb_number] != value)
+                                    {
+                                        auto msb_value = value;
+                                        // see bullet 5 above
+                                        auto lsb_value = 0;
+                                        if (control_change.value_[msb_number] > msb_value)
+                                        {
+                                            lsb_value = 127;
+                                        }
+                                    
+                                        // see bullets 3, 4, 5 above
+                                        handle14BitControlChangeValue(t, channel, msb_number, msb_value, lsb_value);
+                                    }
+                                }
+                                // we also handle the data entry control change for NRPN and RPN here
+                                // since it can potentially be used only as MSB data entry only
+                                else if (number == 6)
+                                {
+                                    handleDataEntryControlChange(t, channel, value, 0);
+                                }
+                            }
+                            else if (number >= 32 && number < 64)
+                            {
+                                auto msb_number = number - 32;
+                                auto& control_change = control_changes.controlChange_;
+                                // see bullet 1 above
+                                if (control_change.time_[msb_number] > 0)
+                                {
+                                    // see bullet 2 above
+                                    int msb_value = control_change.value_[msb_number];
+                                    auto lsb_value = value;
+                                    handle14BitControlChangeValue(t, channel, msb_number, msb_value, lsb_value);
+                                }
+                            }
+                            break;
+                    }
+                
+                    control_changes.active_.add(number);
+                    auto control_change = control_changes.controlChange_.ref(number);
+                    collectHistory(t, control_change);
+                    control_change.value_ = int16(value);
+                    message_time = &control_change.time_;
+                    break;
+                }
+                case 0xc0:
+                {
+                    channel.programChange_.value_[0] = int16(data1);
+                    message_time = &channel.programChange_.time_[0];
+                    break;
+                }
+                case 0xd0:
+                {
+                    auto channel_pressure = channel.channelPressure_.ref(0);
+                    collectHistory(t, channel_pressure);
+                    channel_pressure.value_ = int16(data1);
+                    message_time = &channel_pressure.time_;
+                    break;
+                }
+                case 0xe0:
+                {
+                    auto pitch_bend = channel.pitchBend_.ref(0);
+                    collectHistory(t, pitch_bend);
+                    pitch_bend.value_ = int16(data1 | (data2 << 7));
+                    message_time = &pitch_bend.time_;
+                    break;
+                }
+            }
+            
+            if (message_time != nullptr)
+            {
+                // and when a message that wasn't shown appears
+                layout = layout || isExpired(t, *message_time);
+                *message_time = t;
+                channel.time_ = t;
+                // notes and their poly pressure stay within the notes area
+                markDirty(channel.number_, layout, (status & 0xf0) <= 0xa0);
+            }
+        }
+        
+        void handleNoteOff(Ticks t, ActiveChannel& channel, int number, int velocity, Ticks*& messageTime)
+        {
+            auto& notes = channel.notes_;
+            notes.time_ = t;
+            
+            notes.active_.add(number);
+            notes.off_.value_[number] = int16(velocity);
+            messageTime = &notes.off_.time_[number];
+        }
+        
+        void handleMidiClock(Ticks t)
+        {
+            if (t - channels_.clock_.timeHost_ < HOST_TRANSPORT_HOLD)
+            {
+                return;
+            }
+            
+            auto ts_secs = double(t) / TICKS_PER_SECOND;
+            
+            if (midiClock_.addTick(ts_secs))
+            {
+                auto bpm = midiClock_.getBpm();
+                auto& clock = channels_.clock_;
+
+                // single readings wobble, so a running average smooths
+                // them; after a tempo jump the average starts from a
+                // single reading that may round to the wrong number,
+                // and while it disagrees with the display it catches
+                // up faster, calming down again once they match
+                auto avg_dt = ts_secs - midiClockAvgTime_;
+                if (midiClockAvgTime_ <= 0.0 || avg_dt > 2.0)
+                {
+                    midiClockAvgBpm_ = bpm;
+                }
+                else
+                {
+                    auto correcting = ts_secs - midiClockJumpTime_ < 1.5
+                                      && fabs(midiClockAvgBpm_ - clock.bpm_) >= 0.35;
+                    midiClockAvgBpm_ += std::min(1.0, avg_dt / (correcting ? 0.35 : 1.0)) * (bpm - midiClockAvgBpm_);
+                }
+                midiClockAvgTime_ = ts_secs;
+
+                // only a big change counts as a tempo jump, since the
+                // wobble at high tempos can span a few BPM; small real
+                // changes reach the display through the average anyway
+                if (fabs(bpm - clock.bpm_) >= std::max(4.0, bpm * 0.03))
+                {
+                    midiClockAvgBpm_ = bpm;
+                    midiClockJumpTime_ = ts_secs;
+                }
+
+                // keep the readout alive while the clock is running
+                if (t - clock.timeBpm_ > TICKS_PER_SECOND / 2)
+                {
+                    if (isExpired(t, clock.timeBpm_))
+                    {
+                        dirtySections_ |= DIRTY_ALL;
+                    }
+                    clock.timeBpm_ = t;
+                }
+
+                // the tempo is shown as a whole BPM: MIDI clock only
+                // carries 24 pulses per beat and the receive timing
+                // jitters, so the reading isn't trustworthy below about
+                // a whole BPM anyway. The average has to clearly cross
+                // over to another value before the display follows, and
+                // a step to the next number has to stick around for a
+                // moment first, while a move of several BPM shows
+                // immediately
+                if (fabs(midiClockAvgBpm_ - clock.bpm_) < 0.75)
+                {
+                    midiClockCrossingSince_ = 0.0;
+                }
+                else
+                {
+                    auto target = double(int(midiClockAvgBpm_ + 0.5));
+                    auto neighbour = fabs(target - clock.bpm_) < 2.0;
+                    if (neighbour && midiClockCrossingSince_ <= 0.0)
+                    {
+                        midiClockCrossingSince_ = ts_secs;
+                    }
+                    else if (!neighbour || ts_secs - midiClockCrossingSince_ >= 0.6)
+                    {
+                        midiClockCrossingSince_ = 0.0;
+                        clock.bpm_ = target;
+                        markHeaderDirty(DIRTY_CLOCK, isExpired(t, clock.timeBpm_));
+                    }
+                }
+            }
+        }
+        
+        void handleMidiTransport(Ticks t, Ticks& transportTime)
+        {
+            markHeaderDirty(DIRTY_CLOCK, isTransportExpired(t));
+            transportTime = t;
+            midiClock_.reset();
+            midiClockAvgTime_ = 0.0;
+        }
+        
+        // start, continue and stop share a single line of the clock section
+        bool isTransportExpired(Ticks t) const
+        {
+            auto& clock = channels_.clock_;
+            return isExpired(t, clock.timeStart_) && isExpired(t, clock.timeContinue_) && isExpired(t, clock.timeStop_);
+        }
+
+        void handle14BitControlChangeValue(Ticks t, ActiveChannel& channel, int number, int msbValue, int lsbValue)
+        {
+            auto was_rpn_or_nrpn = false;
+            // handle RPN or NRPN
+            if (number == 6)
+            {
+                was_rpn_or_nrpn = handleDataEntryControlChange(t, channel, msbValue, lsbValue);
+            }
+            
+            // handle Hi-Res Control Change
+            if (!was_rpn_or_nrpn)
+            {
+                auto& hrccs = channel.hrccs_;
+                auto hrcc = hrccs.ref(number);
+                collectHistory(t, hrcc);
+                
+                markDirty(channel.number_, isExpired(t, hrcc.time_));
+                hrccs.time_ = t;
+                hrcc.time_ = t;
+                // see bullet 2 above
+                hrcc.value_ = int16((msbValue << 7) + lsbValue);
+            }
+        }
+        
+        bool handleDataEntryControlChange(Ticks t, ActiveChannel& channel, int msbValue, int lsbValue)
+        {
+            if (channel.lastRpnMsb_ != 127 || channel.lastRpnLsb_ != 127)
+            {
+                auto rpn_number = (channel.lastRpnMsb_ << 7) + channel.lastRpnLsb_;
+                auto rpn_value = (msbValue << 7) + lsbValue;
+                auto& rpns = channel.rpns_;
+                auto rpn = rpns.ref(rpn_number);
+                collectHistory(t, rpn);
+                
+                markDirty(channel.number_, isExpired(t, rpn.time_));
+                rpns.time_ = t;
+                rpn.time_ = t;
+                rpn.value_ = int16(rpn_value);
+                
+                // handle MPE activation message
+                if (rpn_number == 6 && msbValue <= 0xf)
+                {
+                    channels_.handleMpeActivation(t, channel, msbValue);
+                    // this changes the headers of other channels, and can
+                    // make them appear
+                    dirtySections_ |= DIRTY_ALL;
+                }
+                
+                return true;
+            }
+            // handle NRPN
+            else if (channel.lastNrpnMsb_ != 127 || channel.lastNrpnLsb_ != 127)
+            {
+                auto nrpn_number = (channel.lastNrpnMsb_ << 7) + channel.lastNrpnLsb_;
+                auto nrpn_value = (msbValue << 7) + lsbValue;
+                auto& nrpns = channel.nrpns_;
+                auto nrpn = nrpns.ref(nrpn_number);
+                collectHistory(t, nrpn);
+                
+                markDirty(channel.number_, isExpired(t, nrpn.time_));
+                nrpns.time_ = t;
+                nrpn.time_ = t;
+                nrpn.value_ = int16(nrpn_value);
+                
+                return true;
+            }
+            
+            return false;
+        }
+
+        void markDirty(int channel, bool layout, bool notesOnly = false)
+        {
+            if (layout)
+            {
+                dirtySections_ |= (uint64(1) << channel) | (uint64(1) << (16 + channel));
+            }
+            else
+            {
+                dirtySections_ |= uint64(1) << ((notesOnly ? DIRTY_NOTES_SHIFT : 0) + channel);
+            }
+        }
+        
+        // the values of the clock and sysex sections repaint only those,
+        // until a line appears and moves everything below it
+        void markHeaderDirty(uint64 section, bool layout)
+        {
+            dirtySections_ |= layout ? DIRTY_ALL : section;
+        }
+        
+        // keeps the value a message had until now in its history
+        void collectHistory(Ticks t, const MessageRef& message)
+        {
+            if (message.time_ > 0)
+            {
+                auto history = channels_.histories_.acquire(message.history_, message.owner_, t);
+                if (history != nullptr)
+                {
+                    history->addNewest({ message.time_, message.value_ });
+                }
+            }
+        }
+        
+        // keeps held notes alive and drops what has nothing left to show,
+        // this is done on the live state so that painting has no side
+        // effects and can draw a paused snapshot as is
+        void sweepChannels(Ticks t)
+        {
+            for (auto channel_index = 0; channel_index < 16; ++channel_index)
+            {
+                // the page of a channel is only written to when something
+                // changes, so that it stays shared with the snapshots
+                auto& current = channels_.channel(channel_index);
+                if (isExpired(t, current.time_) || !needsSweep(t, current))
+                {
+                    continue;
+                }
+                
+                auto& channel = channels_.writeChannel(channel_index);
+                
+                auto& notes = channel.notes_;
+                for (int a = 0; a < notes.active_.size();)
+                {
+                    auto i = notes.active_[a];
+                    auto note_on_expired = isExpired(t, notes.on_.time_[i]);
+                    auto note_off_expired = isExpired(t, notes.off_.time_[i]);
+                    if (note_on_expired && note_off_expired && isExpired(t, notes.polyPressure_.time_[i]))
+                    {
+                        notes.active_.removeAt(a);
+                        continue;
+                    }
+                    ++a;
+                    
+                    if (isHeldNoteStale(t, notes, i))
+                    {
+                        channel.time_ = t;
+                        notes.on_.time_[i] = t;
+                        notes.time_ = t;
+                    }
+                }
+                
+                auto& control_changes = channel.controlChanges_;
+                for (int a = 0; a < control_changes.active_.size();)
+                {
+                    if (isExpired(t, control_changes.controlChange_.time_[control_changes.active_[a]]))
+                    {
+                        control_changes.active_.removeAt(a);
+                    }
+                    else
+                    {
+                        ++a;
+                    }
+                }
+                
+                pruneParameters(t, channel.hrccs_);
+                pruneParameters(t, channel.rpns_);
+                pruneParameters(t, channel.nrpns_);
+            }
+        }
+        
+        bool needsSweep(Ticks t, const ActiveChannel& channel) const
+        {
+            auto& notes = channel.notes_;
+            for (int a = 0; a < notes.active_.size(); ++a)
+            {
+                auto i = notes.active_[a];
+                if (isHeldNoteStale(t, notes, i) ||
+                    (isExpired(t, notes.on_.time_[i]) && isExpired(t, notes.off_.time_[i]) && isExpired(t, notes.polyPressure_.time_[i])))
+                {
+                    return true;
+                }
+            }
+            
+            auto& control_changes = channel.controlChanges_;
+            for (int a = 0; a < control_changes.active_.size(); ++a)
+            {
+                if (isExpired(t, control_changes.controlChange_.time_[control_changes.active_[a]]))
+                {
+                    return true;
+                }
+            }
+            
+            return hasExpiredParameters(t, channel.hrccs_) ||
+                   hasExpiredParameters(t, channel.rpns_) ||
+                   hasExpiredParameters(t, channel.nrpns_);
+        }
+        
+        // a note that is on without a note off, and whose time should move
+        bool isHeldNoteStale(Ticks t, const Notes& notes, int number) const
+        {
+            return !isExpired(t, notes.on_.time_[number]) && isExpired(t, notes.off_.time_[number]) &&
+                   settings_.getTimeoutDelay() != 0 && t - notes.on_.time_[number] >= HELD_NOTE_REFRESH;
+        }
+        
+        bool hasExpiredParameters(Ticks t, const Parameters& params) const
+        {
+            for (auto index = 0; index < params.param_.size(); ++index)
+            {
+                if (isExpired(t, params.param_.find(params.param_.numberAt(index))->time_))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+        
+        void pruneParameters(Ticks t, Parameters& params)
+        {
+            auto index = 0;
+            while (index < params.param_.size())
+            {
+                auto number = params.param_.numberAt(index);
+                if (isExpired(t, params.param_.find(number)->time_))
+                {
+                    params.param_.remove(number);
+                }
+                else
+                {
+                    ++index;
+                }
+            }
+        }
+        
+        bool isExpired(Ticks currentTime, Ticks messageTime) const
+        {
+            if (messageTime == 0)
+            {
+                return true;
+            }
+            auto delay = settings_.getTimeoutDelay();
+            if (delay == 0)
+            {
+                return false;
+            }
+            return currentTime - messageTime > delay * TICKS_PER_SECOND;
+        }
+        
+        Settings& settings_;
+        
+        // pushed by the MIDI or audio thread, drained by the message thread
+        MidiEventQueue midiQueue_;
+        
+        // only accessed on the message thread
+        ActiveChannels channels_;
+        MidiClockEstimator midiClock_;
+        double midiClockAvgBpm_ { 0.0 };
+        double midiClockAvgTime_ { 0.0 };
+        double midiClockJumpTime_ { 0.0 };
+        double midiClockCrossingSince_ { 0.0 };
+        uint64 dirtySections_ { DIRTY_ALL };
+        std::map<int, uint64> views_;
+        int nextView_ { 0 };
+        Ticks lastActivity_ { currentTicks() };
+        
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Pimpl)
+    };
+    
+    MidiDeviceState::MidiDeviceState(Settings& settings) : pimpl_(new Pimpl(settings)) {}
+    MidiDeviceState::~MidiDeviceState() = default;
+    
+    MidiEventQueue& MidiDeviceState::getQueue()                 { return pimpl_->midiQueue_; }
+    
+    void MidiDeviceState::update(Ticks t)                       { pimpl_->update(t); }
+    void MidiDeviceState::updateHostTransport(Ticks t, double b, double p, bool pl) { pimpl_->updateHostTransport(t, b, p, pl); }
+    void MidiDeviceState::reset()                               { pimpl_->reset(); }
+    
+    const ActiveChannels& MidiDeviceState::getChannels() const  { return pimpl_->channels_; }
+    ActiveChannels& MidiDeviceState::getChannels()              { return pimpl_->channels_; }
+    ActiveChannels MidiDeviceState::snapshot()                  { return pimpl_->channels_.snapshot(); }
+    
+    void MidiDeviceState::writeCapture(Ticks t, MemoryBlock& c) const { SessionCapture::write(pimpl_->channels_, t, c); }
+    void MidiDeviceState::restoreCapture(Ticks t, const MemoryBlock& c) { pimpl_->restoreCapture(t, c); }
+    
+    int MidiDeviceState::attachView()                           { return pimpl_->attachView(); }
+    void MidiDeviceState::detachView(int v)                     { pimpl_->detachView(v); }
+    uint64 MidiDeviceState::takeDirtySections(int v)            { return pimpl_->takeDirtySections(v); }
+    int MidiDeviceState::getNumViews() const                    { return int(pimpl_->views_.size()); }
+    Ticks MidiDeviceState::getLastActivity() const              { return pimpl_->lastActivity_; }
+    bool MidiDeviceState::isExpired(Ticks c, Ticks m) const     { return pimpl_->isExpired(c, m); }
+}
@@ -0,0 +1,73 @@
+/*
+ * This file is part of ShowMIDI.
+ * Copyright (command) 2023 Uwyn LLC.  https://www.uwyn.com
+ *
+ * ShowMIDI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ShowMIDI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "ChannelState.h"
+#include "MidiEventQueue.h"
+#include "Settings.h"
+
+namespace showmidi
+{
+    // the decoded MIDI state of a device, the MIDI or audio thread pushes
+    // into its queue and the message thread applies that to the channels,
+    // regardless of whether they're being displayed
+    class MidiDeviceState
+    {
+    public:
+        // sections of the display that changed: the low 16 bits flag
+        // channels with changed values, the next 16 bits channels with a
+        // changed layout, which moves everything below them; the clock and
+        // the sysex sections have their own bits for changed values, and
+        // channels whose values only changed in their notes have theirs
+        static constexpr uint64 DIRTY_ALL = uint64(1) << 32;
+        static constexpr uint64 DIRTY_CLOCK = uint64(1) << 33;
+        static constexpr uint64 DIRTY_SYSEX = uint64(1) << 34;
+        static constexpr int DIRTY_NOTES_SHIFT = 40;
+        
+        MidiDeviceState(Settings&);
+        ~MidiDeviceState();
+        
+        MidiEventQueue& getQueue();
+        
+        void update(Ticks);
+        void updateHostTransport(Ticks, double bpm, double ppq, bool playing);
+        void reset();
+        
+        const ActiveChannels& getChannels() const;
+        ActiveChannels& getChannels();
+        ActiveChannels snapshot();
+        
+        void writeCapture(Ticks, MemoryBlock&) const;
+        void restoreCapture(Ticks, const MemoryBlock&);
+        
+        int attachView();
+        void detachView(int);
+        uint64 takeDirtySections(int view);
+        int getNumViews() const;
+        Ticks getLastActivity() const;
+        bool isExpired(Ticks, Ticks) const;
+        
+        struct Pimpl;
+    private:
+        std::unique_ptr<Pimpl> pimpl_;
+        
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiDeviceState)
+    };
+}
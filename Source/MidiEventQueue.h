@@ -0,0 +1,134 @@
+/*
+ * This file is part of ShowMIDI.
+ * Copyright (command) 2023 Uwyn LLC.  https://www.uwyn.com
+ *
+ * ShowMIDI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ShowMIDI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "ChannelState.h"
+
+namespace showmidi
+{
+    // a received MIDI message in a compact fixed size form, so that it can
+    // travel from the MIDI thread to the message thread without allocating
+    struct MidiEvent
+    {
+        static constexpr int MAX_EVENT_DATA = Sysex::MAX_SYSEX_DATA;
+
+        Ticks time_ { 0 };
+        bool sysex_ { false };
+        // the full length of the message, for sysex this can be more than
+        // what's kept in the data
+        int length_ { 0 };
+        uint8 data_[MAX_EVENT_DATA] { };
+
+        // the raw bytes of a message, sysex includes the leading 0xF0 and
+        // the trailing 0xF7, like MidiMessage::getRawData()
+        void set(Ticks t, const uint8* data, int size)
+        {
+            time_ = t;
+            sysex_ = size > 0 && data[0] == 0xf0;
+            if (sysex_)
+            {
+                length_ = std::max(0, size - 2);
+                memset(data_, 0, MAX_EVENT_DATA);
+                memcpy(data_, data + 1, std::min(length_, MAX_EVENT_DATA));
+            }
+            else
+            {
+                length_ = std::min(size, MAX_EVENT_DATA);
+                memcpy(data_, data, length_);
+            }
+        }
+    };
+
+    // wait-free single-producer single-consumer queue of MIDI events, the
+    // MIDI or audio thread pushes and the message thread drains once per frame
+    class MidiEventQueue
+    {
+    public:
+        static constexpr int DEFAULT_CAPACITY = 4096;
+
+        MidiEventQueue(int capacity = DEFAULT_CAPACITY) :
+            fifo_(capacity),
+            events_(size_t(capacity))
+        {
+        }
+
+        // producer side, returns false when the consumer fell behind and the
+        // event had to be dropped
+        bool push(Ticks t, const MidiMessage& msg)
+        {
+            return push(t, msg.getRawData(), msg.getRawDataSize());
+        }
+
+        // producer side for raw bytes, which is what the audio thread has
+        // in a MidiBuffer, without constructing a MidiMessage that would
+        // allocate for long sysex
+        bool push(Ticks t, const uint8* data, int size)
+        {
+            const auto scope = fifo_.write(1);
+            if (scope.blockSize1 > 0)
+            {
+                events_[size_t(scope.startIndex1)].set(t, data, size);
+                return true;
+            }
+
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // consumer side, calls the function for each queued event in order
+        template <typename Function>
+        int drain(Function&& function)
+        {
+            const auto ready = fifo_.getNumReady();
+            if (ready > 0)
+            {
+                const auto scope = fifo_.read(ready);
+                for (int i = 0; i < scope.blockSize1; ++i)
+                {
+                    function(events_[size_t(scope.startIndex1 + i)]);
+                }
+                for (int i = 0; i < scope.blockSize2; ++i)
+                {
+                    function(events_[size_t(scope.startIndex2 + i)]);
+                }
+            }
+            return ready;
+        }
+
+        // consumer side, discards everything that's queued
+        void clear()
+        {
+            fifo_.read(fifo_.getNumReady());
+        }
+
+        // the number of events that didn't fit
+        int getNumDropped() const
+        {
+            return dropped_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        AbstractFifo fifo_;
+        std::vector<MidiEvent> events_;
+        std::atomic<int> dropped_ { 0 };
+
+        JUCE_DECLARE_NON_COPYABLE (MidiEventQueue)
+    };
+}
@@ -0,0 +1,100 @@
+/*
+ * This file is part of ShowMIDI.
+ * Copyright (command) 2023 Uwyn LLC.  https://www.uwyn.com
+ *
+ * ShowMIDI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ShowMIDI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "Settings.h"
+
+namespace showmidi
+{
+    // the texts that are drawn for every displayed message, prebuilt for the
+    // current number and note formats so that painting doesn't build any
+    // strings; the tables are only rebuilt when those settings change
+    class OutputStrings
+    {
+    public:
+        const String labelOn_ { "ON" };
+        const String labelOff_ { "OFF" };
+        const String labelPolyPressure_ { "PP" };
+        const String labelPitchBend_ { "PB" };
+        const String labelChannelPressure_ { "CP" };
+        
+        OutputStrings() = default;
+        
+        void update(NumberFormat numberFormat, NoteFormat noteFormat, int octaveMiddleC)
+        {
+            if (built_ && numberFormat == numberFormat_ && noteFormat == noteFormat_ && octaveMiddleC == octaveMiddleC_)
+            {
+                return;
+            }
+            
+            built_ = true;
+            numberFormat_ = numberFormat;
+            noteFormat_ = noteFormat;
+            octaveMiddleC_ = octaveMiddleC;
+            
+            for (auto i = 0; i < 128; ++i)
+            {
+                value7Bit_[i] = numberFormat == NumberFormat::formatHexadecimal ? to7BitHex(i) : String(i);
+                note_[i] = noteFormat == NoteFormat::formatNumber ? value7Bit_[i] : MidiMessage::getMidiNoteName(i, true, true, octaveMiddleC);
+                controlChange_[i] = "CC " + value7Bit_[i];
+                programChange_[i] = "PRGM " + value7Bit_[i];
+            }
+            for (auto i = 0; i < 16; ++i)
+            {
+                channel_[i] = "CH " + value7Bit_[i + 1];
+            }
+        }
+        
+        // values that don't fit in 7 bits, like the status bytes that some
+        // sysex data holds, are formatted as they are
+        String value7Bit(int v) const
+        {
+            if (v < 0 || v > 127)
+            {
+                return numberFormat_ == NumberFormat::formatHexadecimal ? to7BitHex(v) : String(v);
+            }
+            return value7Bit_[v];
+        }
+        
+        const String& note(int noteNumber) const        { return note_[noteNumber & 0x7f]; }
+        const String& controlChange(int number) const   { return controlChange_[number & 0x7f]; }
+        const String& programChange(int program) const  { return programChange_[program & 0x7f]; }
+        const String& channel(int number) const         { return channel_[number & 0xf]; }
+        
+        static String to7BitHex(int v)
+        {
+            return String::toHexString(v).paddedLeft('0', 2).toUpperCase() + "H";
+        }
+        
+    private:
+        bool built_ { false };
+        NumberFormat numberFormat_ { NumberFormat::formatDecimal };
+        NoteFormat noteFormat_ { NoteFormat::formatName };
+        int octaveMiddleC_ { 0 };
+        
+        String value7Bit_[128];
+        String note_[128];
+        String controlChange_[128];
+        String programChange_[128];
+        String channel_[16];
+        
+        JUCE_DECLARE_NON_COPYABLE (OutputStrings)
+    };
+}
@@ -19,6 +19,7 @@
 
 #include "MainLayoutComponent.h"
 #include "MidiDeviceComponent.h"
+#include "PluginInstances.h"
 #include "PluginProcessor.h"
 #include "PluginSettings.h"
 #include "SettingsManager.h"
@@ -27,14 +28,16 @@
 
 namespace showmidi
 {
-    struct ShowMIDIPluginAudioProcessorEditor::Pimpl : public MultiTimer, public SettingsManager, public DeviceManager
+    struct ShowMIDIPluginAudioProcessorEditor::Pimpl : public MultiTimer, public SettingsManager, public DeviceManager, public PluginInstancesListener, public KeyListener
     {
         static constexpr int DEFAULT_EDITOR_HEIGHT = 600;
+        static constexpr int STATS_MARGIN = 8;
         
         enum Timers
         {
             RenderDevices = 1,
-            GrabKeyboardFocus
+            GrabKeyboardFocus,
+            UpdateStats
         };
         
         Pimpl(ShowMIDIPluginAudioProcessorEditor* owner, ShowMIDIPluginAudioProcessor* p) :
@@ -43,20 +46,25 @@ namespace showmidi
         {
             Desktop::getInstance().setDefaultLookAndFeel(&lookAndFeel_);
             
-            midiDevice_ = std::make_unique<MidiDeviceComponent>(this, "ShowMIDI");
-            layout_ = std::make_unique<MainLayoutComponent>(this, this, MainLayoutType::layoutPlugin, midiDevice_.get());
+            // the processor keeps the MIDI state, also while the editor is
+            // closed, the device component only displays it
+            midiDevice_ = std::make_unique<MidiDeviceComponent>(this, "ShowMIDI", p->getMidiState());
+            layout_ = std::make_unique<MainLayoutComponent>(this, this, MainLayoutType::layoutPlugin, &devices_);
+            
+            instances_->addListener(this);
             
             owner_->setResizable(true, true);
             owner_->getConstrainer()->setMinimumWidth(layout_->getSidebarWidth() + MidiDeviceComponent::getStandardWidth() + Theme::SCROLLBAR_THICKNESS);
             owner_->getConstrainer()->setMaximumWidth(owner_->getConstrainer()->getMaximumWidth());
             owner_->getConstrainer()->setMinimumHeight(120);
             
-            midiDevice_->setBounds(0, 0, MidiDeviceComponent::getStandardWidth(), DEFAULT_EDITOR_HEIGHT);
+            layoutDevices();
 
             owner_->addAndMakeVisible(layout_.get());
 
             owner_->setSize(layout_->getWidth(), DEFAULT_EDITOR_HEIGHT);
             owner_->setWantsKeyboardFocus(true);
+            owner_->addKeyListener(this);
             
             // 30Hz
             startTimer(RenderDevices, 1000 / 30);
@@ -69,14 +77,13 @@ namespace showmidi
         
         ~Pimpl()
         {
+            instances_->removeListener(this);
+            owner_->removeKeyListener(this);
+            
             stopTimer(RenderDevices);
+            stopTimer(UpdateStats);
         }
 
-        void handleIncomingMidiMessage(const MidiMessage& msg)
-        {
-            midiDevice_->handleIncomingMidiMessage(msg);
-        }
-        
         bool isPaused() override
         {
             return paused_;
@@ -101,6 +108,10 @@ namespace showmidi
         void resetChannelData() override
         {
             midiDevice_->resetChannelData();
+            for (auto device : otherDevices_)
+            {
+                device->resetChannelData();
+            }
         }
         
         DeviceListeners& getDeviceListeners() override
@@ -113,6 +124,90 @@ namespace showmidi
             paused_ = paused;
             
             midiDevice_->setPaused(paused);
+            for (auto device : otherDevices_)
+            {
+                device->setPaused(paused);
+            }
+        }
+        
+        void pluginInstancesChanged() override
+        {
+            if (showingAllInstances_)
+            {
+                layoutDevices();
+            }
+        }
+        
+        // this editor shows either its own instance, or all the instances in
+        // the host process side by side, which only needs one editor to be
+        // open and rendering instead of one for each track; the instances
+        // keep their own state and settings, this only displays them
+        void layoutDevices()
+        {
+            showingAllInstances_ = getSettings().isShowAllInstances();
+            
+            // the columns of instances that stay shown are kept as they are,
+            // with their paused state and what they cached, only those of
+            // instances that appeared or went away are created or dropped
+            Array<MidiDeviceComponent*> shown;
+            if (showingAllInstances_)
+            {
+                auto processors = instances_->getProcessors();
+                for (auto i = 0; i < processors.size(); ++i)
+                {
+                    auto processor = processors[i];
+                    if (processor == audioProcessor_)
+                    {
+                        shown.add(midiDevice_.get());
+                        continue;
+                    }
+                    
+                    auto name = processor->getTrackName();
+                    if (name.isEmpty())
+                    {
+                        name = "ShowMIDI " + String(i + 1);
+                    }
+                    
+                    auto existing = otherProcessors_.indexOf(processor);
+                    if (existing >= 0)
+                    {
+                        auto device = otherDevices_[existing];
+                        device->setDeviceName(name);
+                        shown.add(device);
+                        continue;
+                    }
+                    
+                    auto device = new MidiDeviceComponent(this, name, processor->getMidiState());
+                    device->setPaused(paused_);
+                    otherDevices_.add(device);
+                    otherProcessors_.add(processor);
+                    shown.add(device);
+                }
+            }
+            else
+            {
+                shown.add(midiDevice_.get());
+            }
+            
+            for (auto i = otherDevices_.size(); --i >= 0;)
+            {
+                if (!shown.contains(otherDevices_[i]))
+                {
+                    otherDevices_.remove(i);
+                    otherProcessors_.remove(i);
+                }
+            }
+            
+            auto position = 0;
+            for (auto device : shown)
+            {
+                device->setBounds(position++ * (MidiDeviceComponent::getStandardWidth() + Theme::MIDI_DEVICE_SPACING), 0,
+                                  MidiDeviceComponent::getStandardWidth(), std::max(devices_.getHeight(), DEFAULT_EDITOR_HEIGHT));
+                devices_.addAndMakeVisible(device);
+            }
+            numShownDevices_ = shown.size();
+            
+            renderDevices();
         }
         
         void timerCallback(int timerID) override
@@ -134,6 +229,67 @@ namespace showmidi
                     }
                     break;
                 }
+                    
+                case UpdateStats:
+                {
+                    owner_->repaint(statsBounds_);
+                    break;
+                }
+            }
+        }
+        
+        // the p key toggles an overlay with the cost of the audio thread
+        bool keyPressed(const KeyPress& key, Component*) override
+        {
+            if (key.getKeyCode() == 'p' || key.getKeyCode() == 'P')
+            {
+                showStats_ = !showStats_;
+                if (showStats_)
+                {
+                    // twice per second
+                    startTimer(UpdateStats, 500);
+                }
+                else
+                {
+                    stopTimer(UpdateStats);
+                }
+                owner_->repaint(statsBounds_);
+                return true;
+            }
+            
+            return false;
+        }
+        
+        void paintOverChildren(Graphics& g)
+        {
+            if (!showStats_)
+            {
+                return;
+            }
+            
+            auto& theme = getSettings().getTheme();
+            auto lines = audioProcessor_->describeProcessBlockStats();
+            
+            auto& font = theme.fontLabel();
+            auto width = 0;
+            for (auto&& line : lines)
+            {
+                width = std::max(width, font.getStringWidth(line));
+            }
+            auto height = lines.size() * theme.labelHeight();
+            
+            statsBounds_ = Rectangle<int>(owner_->getWidth() - width - STATS_MARGIN * 3, owner_->getHeight() - height - STATS_MARGIN * 3,
+                                          width + STATS_MARGIN * 2, height + STATS_MARGIN * 2);
+            g.setColour(theme.colorSidebar.withAlpha(0.9f));
+            g.fillRect(statsBounds_);
+            
+            g.setColour(theme.colorData);
+            g.setFont(font);
+            auto y = statsBounds_.getY() + STATS_MARGIN;
+            for (auto&& line : lines)
+            {
+                g.drawText(line, statsBounds_.getX() + STATS_MARGIN, y, width, theme.labelHeight(), Justification::centredLeft);
+                y += theme.labelHeight();
             }
         }
         
@@ -148,9 +304,27 @@ namespace showmidi
             {
                 height = owner_->getHeight();
             }
+            
+            if (getSettings().isShowAllInstances() != showingAllInstances_)
+            {
+                layoutDevices();
+                return;
+            }
+            
             midiDevice_->render();
             height = std::max(height, midiDevice_->getVisibleHeight());
+            for (auto device : otherDevices_)
+            {
+                device->render();
+                height = std::max(height, device->getVisibleHeight());
+            }
+            
+            devices_.setSize(numShownDevices_ * (MidiDeviceComponent::getStandardWidth() + Theme::MIDI_DEVICE_SPACING) - Theme::MIDI_DEVICE_SPACING, height);
             midiDevice_->setSize(MidiDeviceComponent::getStandardWidth(), height);
+            for (auto device : otherDevices_)
+            {
+                device->setSize(MidiDeviceComponent::getStandardWidth(), height);
+            }
         }
         
         void paint(Graphics& g)
@@ -203,13 +377,24 @@ namespace showmidi
         ShowMIDIPluginAudioProcessorEditor* const owner_;
         ShowMIDIPluginAudioProcessor* const audioProcessor_;
         
+        SharedResourcePointer<PluginInstances> instances_;
+        
+        Component devices_;
         std::unique_ptr<MidiDeviceComponent> midiDevice_;
+        // the columns of the other instances, along with their processors
+        OwnedArray<MidiDeviceComponent> otherDevices_;
+        Array<ShowMIDIPluginAudioProcessor*> otherProcessors_;
+        bool showingAllInstances_ { false };
+        int numShownDevices_ { 1 };
         std::unique_ptr<MainLayoutComponent> layout_;
         
         MidiDevicesListeners midiDevicesListeners_;
 
         bool paused_ { false };
         DeviceListeners deviceListeners_;
+        
+        bool showStats_ { false };
+        Rectangle<int> statsBounds_;
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Pimpl)
     };
@@ -219,8 +404,6 @@ namespace showmidi
 
     ShowMIDIPluginAudioProcessorEditor::~ShowMIDIPluginAudioProcessorEditor() = default;
     
-    void ShowMIDIPluginAudioProcessorEditor::handleIncomingMidiMessage(const MidiMessage& m)   { pimpl_->handleIncomingMidiMessage(m); };
-
     void ShowMIDIPluginAudioProcessorEditor::paint(Graphics& g)
     {
         if (pimpl_.get())
@@ -229,6 +412,14 @@ namespace showmidi
         }
     }
     
+    void ShowMIDIPluginAudioProcessorEditor::paintOverChildren(Graphics& g)
+    {
+        if (pimpl_.get())
+        {
+            pimpl_->paintOverChildren(g);
+        }
+    }
+    
     void ShowMIDIPluginAudioProcessorEditor::resized()
     {
         if (pimpl_.get() && isVisible() && getHeight() > 0)
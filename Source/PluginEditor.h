@@ -29,9 +29,8 @@ namespace showmidi
         ShowMIDIPluginAudioProcessorEditor(ShowMIDIPluginAudioProcessor*);
         ~ShowMIDIPluginAudioProcessorEditor() override;
         
-        void handleIncomingMidiMessage(const MidiMessage&);
-
         void paint(Graphics&) override;
+        void paintOverChildren(Graphics&) override;
         void resized() override;
 
         struct Pimpl;
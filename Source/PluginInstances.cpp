@@ -0,0 +1,87 @@
+/*
+ * This file is part of ShowMIDI.
+ * Copyright (command) 2023 Uwyn LLC.  https://www.uwyn.com
+ *
+ * ShowMIDI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ShowMIDI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "PluginInstances.h"
+
+namespace showmidi
+{
+    PluginInstancesListener::PluginInstancesListener()  { }
+    PluginInstancesListener::~PluginInstancesListener() { }
+    
+    PluginInstances::PluginInstances()  { }
+    
+    PluginInstances::~PluginInstances()
+    {
+        cancelPendingUpdate();
+    }
+    
+    void PluginInstances::add(ShowMIDIPluginAudioProcessor* processor)
+    {
+        {
+            ScopedLock guard(lock_);
+            processors_.addIfNotAlreadyThere(processor);
+        }
+        broadcastChange();
+    }
+    
+    void PluginInstances::remove(ShowMIDIPluginAudioProcessor* processor)
+    {
+        {
+            ScopedLock guard(lock_);
+            processors_.removeFirstMatchingValue(processor);
+        }
+        broadcastChange();
+    }
+    
+    // on the message thread the listeners are told synchronously, so that no
+    // editor keeps showing the state of a processor that's being destroyed,
+    // from any other thread the change is posted to the message thread
+    void PluginInstances::broadcastChange()
+    {
+        if (MessageManager::existsAndIsCurrentThread())
+        {
+            cancelPendingUpdate();
+            handleAsyncUpdate();
+        }
+        else
+        {
+            triggerAsyncUpdate();
+        }
+    }
+    
+    void PluginInstances::handleAsyncUpdate()
+    {
+        listeners_.call([] (PluginInstancesListener& l) { l.pluginInstancesChanged(); });
+    }
+    
+    // a copy, since processors can come and go on other threads meanwhile
+    Array<ShowMIDIPluginAudioProcessor*> PluginInstances::getProcessors() const
+    {
+        ScopedLock guard(lock_);
+        return processors_;
+    }
+    
+    void PluginInstances::addListener(PluginInstancesListener* listener)
+    {
+        listeners_.add(listener);
+    }
+    
+    void PluginInstances::removeListener(PluginInstancesListener* listener)
+    {
+        listeners_.remove(listener);
+    }
+}
@@ -0,0 +1,64 @@
+/*
+ * This file is part of ShowMIDI.
+ * Copyright (command) 2023 Uwyn LLC.  https://www.uwyn.com
+ *
+ * ShowMIDI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ShowMIDI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace showmidi
+{
+    class ShowMIDIPluginAudioProcessor;
+    
+    class PluginInstancesListener
+    {
+    public:
+        PluginInstancesListener();
+        virtual ~PluginInstancesListener();
+        
+        virtual void pluginInstancesChanged() = 0;
+    };
+    
+    // the plugin instances that are alive in this host process, shared by all
+    // of them through a SharedResourcePointer, so that any one editor can show
+    // them all; hosts can create and destroy processors on any thread, so the
+    // instances are guarded by a lock and the listeners are always told on
+    // the message thread, the audio threads never touch it
+    class PluginInstances : private AsyncUpdater
+    {
+    public:
+        PluginInstances();
+        ~PluginInstances() override;
+        
+        void add(ShowMIDIPluginAudioProcessor*);
+        void remove(ShowMIDIPluginAudioProcessor*);
+        void broadcastChange();
+        
+        Array<ShowMIDIPluginAudioProcessor*> getProcessors() const;
+        
+        void addListener(PluginInstancesListener*);
+        void removeListener(PluginInstancesListener*);
+        
+    private:
+        void handleAsyncUpdate() override;
+        
+        CriticalSection lock_;
+        Array<ShowMIDIPluginAudioProcessor*> processors_;
+        ListenerList<PluginInstancesListener> listeners_;
+        
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginInstances)
+    };
+}
@@ -18,15 +18,24 @@
 #include "PluginProcessor.h"
 
 #include "PluginEditor.h"
+#include "SessionCapture.h"
 
 namespace showmidi
 {
     ShowMIDIPluginAudioProcessor::ShowMIDIPluginAudioProcessor() : AudioProcessor(BusesProperties())
     {
+        // 30Hz
+        startTimer(1000 / 30);
+        
+        instances_->add(this);
     }
     
     ShowMIDIPluginAudioProcessor::~ShowMIDIPluginAudioProcessor()
     {
+        instances_->remove(this);
+        
+        cancelPendingUpdate();
+        stopTimer();
     }
     
     const String ShowMIDIPluginAudioProcessor::getName() const
@@ -77,26 +86,158 @@ namespace showmidi
     {
     }
 
-    void ShowMIDIPluginAudioProcessor::prepareToPlay(double, int)
+    void ShowMIDIPluginAudioProcessor::prepareToPlay(double sampleRate, int)
     {
+        sampleRate_ = sampleRate > 0.0 ? sampleRate : DEFAULT_SAMPLE_RATE;
+        nextBlockStart_ = 0;
+        hostTransport_.store({});
+        processBlockStats_.reset();
     }
 
     void ShowMIDIPluginAudioProcessor::releaseResources()
     {
     }
 
-    void ShowMIDIPluginAudioProcessor::processBlock(AudioBuffer<float>&, MidiBuffer& midiMessages)
+    void ShowMIDIPluginAudioProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiMessages)
     {
         ScopedNoDenormals noDenormals;
         
-        for (const MidiMessageMetadata metadata : midiMessages)
+        const auto process_start = Time::getHighResolutionTicks();
+        
+        const auto ticks_per_sample = double(TICKS_PER_SECOND) / sampleRate_;
+        const auto block_length = Ticks(buffer.getNumSamples() * ticks_per_sample);
+        
+        // consecutive blocks are laid out back to back on the timeline, since
+        // the callbacks themselves jitter by far more than a sample; the
+        // timeline is slowly pulled towards the clock to follow the drift of
+        // the audio device, and starts over when it's off by more than a block,
+        // like after the host was suspended
+        const auto now = currentTicks();
+        auto block_start = nextBlockStart_;
+        if (block_start == 0 || std::abs(now - block_start) > std::max(block_length, RENDER_TIME_UNIT_TICKS))
+        {
+            block_start = now;
+        }
+        else
+        {
+            block_start += (now - block_start) / CLOCK_FOLLOW_DIVISOR;
+        }
+        nextBlockStart_ = block_start + block_length;
+        
+        // the host's transport is published once per block, the timer picks
+        // up the latest one
+        if (auto play_head = getPlayHead())
         {
-            auto editor = (ShowMIDIPluginAudioProcessorEditor*)getActiveEditor();
-            if (editor != nullptr)
+            if (auto position = play_head->getPosition())
             {
-                editor->handleIncomingMidiMessage(metadata.getMessage());
+                if (auto bpm = position->getBpm())
+                {
+                    HostTransport transport;
+                    transport.time_ = block_start;
+                    transport.bpm_ = *bpm;
+                    transport.ppq_ = position->getPpqPosition().orFallback(0.0);
+                    transport.playing_ = position->getIsPlaying();
+                    hostTransport_.store(transport);
+                }
             }
         }
+        
+        // the audio thread never looks at the individual events, the raw
+        // bytes of the block are copied in one go into the preallocated
+        // queue, without locking or allocating; unless the MIDI is set to
+        // pass through untouched while nothing shows or captures it
+        if (listening_.load(std::memory_order_relaxed))
+        {
+            blockQueue_.push(block_start, ticks_per_sample, midiMessages);
+        }
+        
+        processBlockStats_.record(double(Time::getHighResolutionTicks() - process_start) * nsPerHighResolutionTick_);
+    }
+    
+    void ShowMIDIPluginAudioProcessor::timerCallback()
+    {
+        // only newly published transport is applied, so that it expires
+        // like any other message once the host stops providing it
+        auto transport = hostTransport_.load();
+        if (transport.time_ > appliedHostTime_)
+        {
+            appliedHostTime_ = transport.time_;
+            midiState_.updateHostTransport(transport.time_, transport.bpm_, transport.ppq_, transport.playing_);
+        }
+        
+        // the events of the queued blocks are taken apart here, their times
+        // never go backwards, even when the timeline was corrected
+        auto& queue = midiState_.getQueue();
+        blockQueue_.drain(drainedBlock_, [this, &queue] (Ticks start, double ticks_per_sample, const MidiBuffer& block)
+        {
+            auto num_events = 0;
+            for (const auto metadata : block)
+            {
+                lastEventTime_ = std::max(lastEventTime_, start + Ticks(metadata.samplePosition * ticks_per_sample));
+                queue.push(lastEventTime_, metadata.data, metadata.numBytes);
+                ++num_events;
+            }
+            processBlockStats_.recordEvents(num_events);
+        });
+        
+        // a capture restored from the project replaces what was shown so far
+        MemoryBlock restored;
+        auto restore = false;
+        {
+            ScopedLock guard(captureLock_);
+            restore = capturePending_;
+            capturePending_ = false;
+            restored.swapWith(pendingCapture_);
+        }
+        if (restore)
+        {
+            midiState_.restoreCapture(currentTicks(), restored);
+        }
+        
+        midiState_.update(currentTicks());
+        
+        if (--captureCountdown_ <= 0)
+        {
+            // the timer runs at 30Hz
+            captureCountdown_ = CAPTURE_INTERVAL_SECONDS * 30;
+            updateCapture();
+        }
+        
+        // by default the state keeps up with the MIDI while the editor is
+        // closed, so that opening it shows the latest activity right away
+        listening_.store(settings_.isMonitorWhileClosed() ||
+                         midiState_.getNumViews() > 0 ||
+                         settings_.isStoreSessionCapture(), std::memory_order_relaxed);
+        
+#if JUCE_DEBUG
+        if (--statsLogCountdown_ <= 0)
+        {
+            // the timer runs at 30Hz
+            statsLogCountdown_ = STATS_LOG_INTERVAL_SECONDS * 30;
+            DBG(describeProcessBlockStats().joinIntoString(", "));
+        }
+#endif
+    }
+    
+    void ShowMIDIPluginAudioProcessor::updateCapture()
+    {
+        // only encoded again when something was received since the last time,
+        // so that frequent autosaves of an idle project cost nothing
+        auto activity = settings_.isStoreSessionCapture() ? midiState_.getLastActivity() : Ticks(0);
+        if (activity == capturedActivity_)
+        {
+            return;
+        }
+        capturedActivity_ = activity;
+        
+        MemoryBlock capture;
+        if (activity != 0)
+        {
+            midiState_.writeCapture(currentTicks(), capture);
+        }
+        
+        ScopedLock guard(captureLock_);
+        capture_.swapWith(capture);
     }
     
     bool ShowMIDIPluginAudioProcessor::hasEditor() const
@@ -118,6 +259,9 @@ namespace showmidi
         {
             copyXmlToBinary(*xml_state, destData);
         }
+        
+        ScopedLock guard(captureLock_);
+        SessionCapture::appendTrailer(destData, capture_);
     }
     
     void ShowMIDIPluginAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
@@ -127,12 +271,57 @@ namespace showmidi
             auto state = ValueTree::fromXml(*xml_state);
             settings_.copyValueTree(state);
         }
+        
+        MemoryBlock capture;
+        if (SessionCapture::findTrailer(data, sizeInBytes, capture))
+        {
+            ScopedLock guard(captureLock_);
+            pendingCapture_.swapWith(capture);
+            capturePending_ = true;
+        }
+    }
+    
+    void ShowMIDIPluginAudioProcessor::updateTrackProperties(const TrackProperties& properties)
+    {
+        {
+            ScopedLock guard(trackNameLock_);
+            trackName_ = properties.name;
+        }
+        
+        // the editors that show this instance pick up the name on the message thread
+        triggerAsyncUpdate();
+    }
+    
+    void ShowMIDIPluginAudioProcessor::handleAsyncUpdate()
+    {
+        instances_->broadcastChange();
     }
     
     PluginSettings& ShowMIDIPluginAudioProcessor::getSettings()
     {
         return settings_;
     }
+    
+    MidiDeviceState& ShowMIDIPluginAudioProcessor::getMidiState()
+    {
+        return midiState_;
+    }
+    
+    // the processBlock statistics, along with what didn't fit in the queues
+    // because the message thread fell behind
+    StringArray ShowMIDIPluginAudioProcessor::describeProcessBlockStats()
+    {
+        auto lines = processBlockStats_.describe();
+        lines.add("dropped blocks " + String(blockQueue_.getNumDropped()) +
+                  " events " + String(midiState_.getQueue().getNumDropped()));
+        return lines;
+    }
+    
+    String ShowMIDIPluginAudioProcessor::getTrackName()
+    {
+        ScopedLock guard(trackNameLock_);
+        return trackName_;
+    }
 }
 
 AudioProcessor* JUCE_CALLTYPE createPluginFilter()
@@ -19,11 +19,16 @@
 
 #include <JuceHeader.h>
 
+#include "MidiBlockQueue.h"
+#include "MidiDeviceState.h"
+#include "PluginInstances.h"
 #include "PluginSettings.h"
+#include "ProcessBlockStats.h"
+#include "SeqLock.h"
 
 namespace showmidi
 {
-    class ShowMIDIPluginAudioProcessor  : public AudioProcessor
+    class ShowMIDIPluginAudioProcessor  : public AudioProcessor, private Timer, private AsyncUpdater
     {
     public:
         ShowMIDIPluginAudioProcessor();
@@ -53,10 +58,72 @@ namespace showmidi
         void getStateInformation(MemoryBlock& destData) override;
         void setStateInformation(const void* data, int sizeInBytes) override;
         
+        void updateTrackProperties(const TrackProperties& properties) override;
+        
         PluginSettings& getSettings();
+        MidiDeviceState& getMidiState();
+        StringArray describeProcessBlockStats();
+        String getTrackName();
         
     private:
+        static constexpr double DEFAULT_SAMPLE_RATE = 44100.0;
+        static constexpr int CLOCK_FOLLOW_DIVISOR = 64;
+        static constexpr int STATS_LOG_INTERVAL_SECONDS = 10;
+        static constexpr int CAPTURE_INTERVAL_SECONDS = 1;
+        
+        void timerCallback() override;
+        void handleAsyncUpdate() override;
+        void updateCapture();
+        
         PluginSettings settings_;
+        // filled by the audio thread, kept up to date on the message thread
+        // whether the editor is open or not
+        MidiDeviceState midiState_ { settings_ };
+        
+        // audio thread only, blocks are laid out on the timeline
+        double sampleRate_ { DEFAULT_SAMPLE_RATE };
+        Ticks nextBlockStart_ { 0 };
+        
+        // the raw MIDI of whole blocks, the message thread times the events
+        // by their sample position from the start of their block; they're
+        // only queued while the MIDI is monitored
+        MidiBlockQueue blockQueue_;
+        std::atomic<bool> listening_ { true };
+        MidiBuffer drainedBlock_;
+        Ticks lastEventTime_ { 0 };
+        
+        struct HostTransport
+        {
+            Ticks time_ { 0 };
+            double bpm_ { 0.0 };
+            double ppq_ { 0.0 };
+            bool playing_ { false };
+        };
+        
+        // the host's transport, published by the audio thread without waiting,
+        // the timer always reads all the values of the same block
+        SeqLock<HostTransport> hostTransport_;
+        Ticks appliedHostTime_ { 0 };
+        
+        // the cost of processBlock itself, measured on the audio thread
+        const double nsPerHighResolutionTick_ { 1000000000.0 / double(Time::getHighResolutionTicksPerSecond()) };
+        ProcessBlockStats processBlockStats_;
+        int statsLogCountdown_ { 0 };
+        
+        // the session capture is encoded on the message thread, the host can
+        // ask for the state from any thread and only copies the latest one
+        CriticalSection captureLock_;
+        MemoryBlock capture_;
+        MemoryBlock pendingCapture_;
+        bool capturePending_ { false };
+        Ticks capturedActivity_ { 0 };
+        int captureCountdown_ { 0 };
+        
+        // the host can name the track at any time and from any thread
+        CriticalSection trackNameLock_;
+        String trackName_;
+        
+        SharedResourcePointer<PluginInstances> instances_;
         
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ShowMIDIPluginAudioProcessor)
     };
@@ -158,6 +158,36 @@ namespace showmidi
     {
         // no-op
     }
+    
+    bool PluginSettings::isShowAllInstances()
+    {
+        return settings_.getProperty(PropertiesSettings::SHOW_ALL_INSTANCES, false);
+    }
+    
+    void PluginSettings::setShowAllInstances(bool all)
+    {
+        settings_.setProperty(PropertiesSettings::SHOW_ALL_INSTANCES, all, nullptr);
+    }
+    
+    bool PluginSettings::isStoreSessionCapture()
+    {
+        return settings_.getProperty(PropertiesSettings::STORE_SESSION_CAPTURE, false);
+    }
+    
+    void PluginSettings::setStoreSessionCapture(bool store)
+    {
+        settings_.setProperty(PropertiesSettings::STORE_SESSION_CAPTURE, store, nullptr);
+    }
+    
+    bool PluginSettings::isMonitorWhileClosed()
+    {
+        return settings_.getProperty(PropertiesSettings::MONITOR_WHILE_CLOSED, true);
+    }
+    
+    void PluginSettings::setMonitorWhileClosed(bool monitor)
+    {
+        settings_.setProperty(PropertiesSettings::MONITOR_WHILE_CLOSED, monitor, nullptr);
+    }
 
     ValueTree& PluginSettings::getValueTree()
     {
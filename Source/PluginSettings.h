@@ -64,6 +64,15 @@ namespace showmidi
         
         bool isAutoHideInactiveDevices();
         void setAutoHideInactiveDevices(bool);
+        
+        bool isShowAllInstances();
+        void setShowAllInstances(bool);
+        
+        bool isStoreSessionCapture();
+        void setStoreSessionCapture(bool);
+        
+        bool isMonitorWhileClosed();
+        void setMonitorWhileClosed(bool);
 
         ValueTree& getValueTree();
         void copyValueTree(ValueTree&);
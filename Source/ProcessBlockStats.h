@@ -0,0 +1,169 @@
+/*
+ * This file is part of ShowMIDI.
+ * Copyright (command) 2023 Uwyn LLC.  https://www.uwyn.com
+ *
+ * ShowMIDI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ShowMIDI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "SeqLock.h"
+
+namespace showmidi
+{
+    // how long the audio thread spends in processBlock, collected since the
+    // processor was prepared; the audio thread is the only writer of the
+    // durations and never waits, the events per block are counted by the
+    // message thread as it takes the queued blocks apart, any other thread
+    // can read a summary at any time
+    class ProcessBlockStats
+    {
+    public:
+        // blocks are counted in a histogram with a quarter of a microsecond
+        // resolution, longer blocks only count towards the maximum
+        static constexpr int NUM_BUCKETS = 256;
+        static constexpr double BUCKET_NS = 250.0;
+        
+        struct Summary
+        {
+            int64 numBlocks_ { 0 };
+            double minNs_ { 0.0 };
+            double meanNs_ { 0.0 };
+            double p99Ns_ { 0.0 };
+            double maxNs_ { 0.0 };
+            double meanEvents_ { 0.0 };
+            int maxEvents_ { 0 };
+        };
+        
+        ProcessBlockStats()
+        {
+            reset();
+        }
+        
+        // only while the audio thread isn't running, like in prepareToPlay
+        void reset()
+        {
+            totals_ = Totals();
+            published_.store(totals_);
+            totalEvents_.store(0, std::memory_order_relaxed);
+            maxEvents_.store(0, std::memory_order_relaxed);
+            for (auto& bucket : buckets_)
+            {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+        
+        // audio thread, the totals are accumulated privately and published
+        // as a whole after every block
+        void record(double ns)
+        {
+            if (totals_.numBlocks_ == 0 || ns < totals_.minNs_)
+            {
+                totals_.minNs_ = ns;
+            }
+            totals_.maxNs_ = std::max(totals_.maxNs_, ns);
+            totals_.totalNs_ += ns;
+            ++totals_.numBlocks_;
+            
+            auto& bucket = buckets_[std::min(NUM_BUCKETS, int(ns / BUCKET_NS))];
+            bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            
+            published_.store(totals_);
+        }
+        
+        // message thread, the events of a block that was taken apart, the
+        // audio thread itself never looks at them
+        void recordEvents(int numEvents)
+        {
+            totalEvents_.store(totalEvents_.load(std::memory_order_relaxed) + numEvents, std::memory_order_relaxed);
+            if (numEvents > maxEvents_.load(std::memory_order_relaxed))
+            {
+                maxEvents_.store(numEvents, std::memory_order_relaxed);
+            }
+        }
+        
+        // any thread, the totals are always those of the same block, only the
+        // histogram can be a block apart from them
+        Summary summarize() const
+        {
+            const auto totals = published_.load();
+            
+            Summary summary;
+            summary.numBlocks_ = totals.numBlocks_;
+            if (summary.numBlocks_ == 0)
+            {
+                return summary;
+            }
+            
+            summary.minNs_ = totals.minNs_;
+            summary.maxNs_ = totals.maxNs_;
+            summary.meanNs_ = totals.totalNs_ / double(summary.numBlocks_);
+            summary.meanEvents_ = double(totalEvents_.load(std::memory_order_relaxed)) / double(summary.numBlocks_);
+            summary.maxEvents_ = maxEvents_.load(std::memory_order_relaxed);
+            
+            // the upper bound of the bucket that holds the 99th percentile,
+            // found by walking down from the slowest blocks
+            auto above = summary.numBlocks_ - (summary.numBlocks_ * 99 + 99) / 100;
+            summary.p99Ns_ = summary.maxNs_;
+            for (auto b = NUM_BUCKETS; b >= 0; --b)
+            {
+                above -= int64(buckets_[b].load(std::memory_order_relaxed));
+                if (above < 0)
+                {
+                    if (b < NUM_BUCKETS)
+                    {
+                        summary.p99Ns_ = std::min(summary.maxNs_, (b + 1) * BUCKET_NS);
+                    }
+                    break;
+                }
+            }
+            
+            return summary;
+        }
+        
+        // the summary as lines of text, for the overlay and the log
+        StringArray describe() const
+        {
+            auto summary = summarize();
+            auto us = [] (double ns) { return String(ns / 1000.0, 2); };
+            
+            StringArray lines;
+            lines.add("processBlock " + String(summary.numBlocks_) + " blocks");
+            lines.add("us min " + us(summary.minNs_) + " mean " + us(summary.meanNs_) +
+                      " p99 " + us(summary.p99Ns_) + " max " + us(summary.maxNs_));
+            lines.add("events/block mean " + String(summary.meanEvents_, 1) + " max " + String(summary.maxEvents_));
+            return lines;
+        }
+        
+    private:
+        struct Totals
+        {
+            int64 numBlocks_ { 0 };
+            double totalNs_ { 0.0 };
+            double minNs_ { 0.0 };
+            double maxNs_ { 0.0 };
+        };
+        
+        // only touched by the audio thread
+        Totals totals_;
+        SeqLock<Totals> published_;
+        std::atomic<int64> totalEvents_ { 0 };
+        std::atomic<int> maxEvents_ { 0 };
+        // the last bucket counts the blocks that took longer
+        std::atomic<uint32> buckets_[NUM_BUCKETS + 1];
+        
+        JUCE_DECLARE_NON_COPYABLE (ProcessBlockStats)
+    };
+}
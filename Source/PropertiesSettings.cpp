@@ -30,6 +30,9 @@ namespace showmidi
     const String PropertiesSettings::MIDI_DEVICE_PINNED_PREFIX = { "midiDevice:pinned:" };
     const String PropertiesSettings::SIDEBAR_EXPANDED = { "sidebarExpanded" };
     const String PropertiesSettings::AUTO_HIDE_INACTIVE_DEVICES = { "autoHideInactiveDevices" };
+    const String PropertiesSettings::SHOW_ALL_INSTANCES = { "showAllInstances" };
+    const String PropertiesSettings::STORE_SESSION_CAPTURE = { "storeSessionCapture" };
+    const String PropertiesSettings::MONITOR_WHILE_CLOSED = { "monitorWhileClosed" };
     const String PropertiesSettings::THEME = { "theme" };
 
     PropertiesSettings::PropertiesSettings()
@@ -172,6 +175,39 @@ namespace showmidi
         getGlobalProperties().setValue(AUTO_HIDE_INACTIVE_DEVICES, autoHide);
         flush();
     }
+    
+    bool PropertiesSettings::isShowAllInstances()
+    {
+        // the standalone app shows MIDI devices, there are no plugin instances
+        return false;
+    }
+    
+    void PropertiesSettings::setShowAllInstances(bool)
+    {
+        // no-op
+    }
+    
+    bool PropertiesSettings::isStoreSessionCapture()
+    {
+        // the standalone app has no project to store the session in
+        return false;
+    }
+    
+    void PropertiesSettings::setStoreSessionCapture(bool)
+    {
+        // no-op
+    }
+    
+    bool PropertiesSettings::isMonitorWhileClosed()
+    {
+        // the standalone app always shows its devices
+        return true;
+    }
+    
+    void PropertiesSettings::setMonitorWhileClosed(bool)
+    {
+        // no-op
+    }
 
     PropertiesFile& PropertiesSettings::getGlobalProperties()
     {
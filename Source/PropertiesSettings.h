@@ -37,6 +37,9 @@ namespace showmidi
         static const String MIDI_DEVICE_PINNED_PREFIX;
         static const String SIDEBAR_EXPANDED;
         static const String AUTO_HIDE_INACTIVE_DEVICES;
+        static const String SHOW_ALL_INSTANCES;
+        static const String STORE_SESSION_CAPTURE;
+        static const String MONITOR_WHILE_CLOSED;
         static const String THEME;
         
         PropertiesSettings();
@@ -77,6 +80,15 @@ namespace showmidi
         
         bool isAutoHideInactiveDevices();
         void setAutoHideInactiveDevices(bool);
+        
+        bool isShowAllInstances();
+        void setShowAllInstances(bool);
+        
+        bool isStoreSessionCapture();
+        void setStoreSessionCapture(bool);
+        
+        bool isMonitorWhileClosed();
+        void setMonitorWhileClosed(bool);
 
         void flush();
         
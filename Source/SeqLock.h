@@ -0,0 +1,88 @@
+/*
+ * This file is part of ShowMIDI.
+ * Copyright (command) 2023 Uwyn LLC.  https://www.uwyn.com
+ *
+ * ShowMIDI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ShowMIDI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace showmidi
+{
+    // a value published by a single writer that never waits, readers on any
+    // other thread retry until they got a copy that wasn't being written in
+    // the meantime, so that they always see a complete and consistent frame;
+    // the value is kept in atomic words, so that the copying itself isn't a
+    // data race either
+    template <typename T>
+    class SeqLock
+    {
+    public:
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values can be copied word by word");
+        
+        SeqLock()
+        {
+            store(T());
+        }
+        
+        // writer side
+        void store(const T& value)
+        {
+            uint64 words[NUM_WORDS] { };
+            memcpy(words, &value, sizeof(T));
+            
+            // an odd sequence tells the readers that a write is in progress
+            const auto sequence = sequence_.load(std::memory_order_relaxed);
+            sequence_.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (auto i = 0; i < NUM_WORDS; ++i)
+            {
+                words_[i].store(words[i], std::memory_order_relaxed);
+            }
+            sequence_.store(sequence + 2, std::memory_order_release);
+        }
+        
+        // reader side, any thread
+        T load() const
+        {
+            uint64 words[NUM_WORDS];
+            for (;;)
+            {
+                const auto before = sequence_.load(std::memory_order_acquire);
+                for (auto i = 0; i < NUM_WORDS; ++i)
+                {
+                    words[i] = words_[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if ((before & 1) == 0 && sequence_.load(std::memory_order_relaxed) == before)
+                {
+                    break;
+                }
+            }
+            
+            T value;
+            memcpy(&value, words, sizeof(T));
+            return value;
+        }
+        
+    private:
+        static constexpr int NUM_WORDS = int((sizeof(T) + sizeof(uint64) - 1) / sizeof(uint64));
+        
+        std::atomic<uint64> sequence_ { 0 };
+        std::atomic<uint64> words_[NUM_WORDS];
+        
+        JUCE_DECLARE_NON_COPYABLE (SeqLock)
+    };
+}
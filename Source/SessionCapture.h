@@ -0,0 +1,359 @@
+/*
+ * This file is part of ShowMIDI.
+ * Copyright (command) 2023 Uwyn LLC.  https://www.uwyn.com
+ *
+ * ShowMIDI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ShowMIDI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "ChannelState.h"
+
+namespace showmidi
+{
+    // a compact binary capture of the latest value of everything a device
+    // shows, for plugins to keep in their project state; the messages are
+    // stored newest first, each timed in milliseconds relative to the one
+    // before it, and all numbers are variable-length encoded, so that a
+    // typical capture takes a few hundred bytes
+    class SessionCapture
+    {
+    public:
+        static constexpr uint8 VERSION = 1;
+        // only the newest messages are kept beyond this
+        static constexpr int MAX_RECORDS = 2048;
+        
+        // appended after the plugin's own state, which hosts and older
+        // versions that don't know about it simply ignore
+        static constexpr uint32 TRAILER_MAGIC = 0x43534d53; // SMSC
+        static constexpr int TRAILER_SIZE = 8;
+        
+        // encodes the channels into a capture, the times are taken relative to now
+        static void write(const ActiveChannels& channels, Ticks now, MemoryBlock& capture)
+        {
+            std::vector<Record> records;
+            collect(channels, records);
+            
+            std::sort(records.begin(), records.end(), [] (const Record& a, const Record& b) { return a.time_ > b.time_; });
+            if (records.size() > size_t(MAX_RECORDS))
+            {
+                records.resize(size_t(MAX_RECORDS));
+            }
+            
+            capture.reset();
+            MemoryOutputStream out(capture, false);
+            out.writeByte(char(VERSION));
+            writeVarint(out, uint32(records.size()));
+            
+            auto previous_ms = now / TICKS_PER_MS;
+            for (auto& record : records)
+            {
+                auto ms = record.time_ / TICKS_PER_MS;
+                writeVarint(out, uint32(std::max(Ticks(0), std::min(previous_ms - ms, Ticks(0xffffffff)))));
+                previous_ms = ms;
+                
+                out.writeByte(char(record.tag_));
+                if (hasNumber(record.tag_ >> 4))
+                {
+                    writeVarint(out, uint32(uint16(record.number_)));
+                }
+                writeVarint(out, uint32(uint16(record.value_)));
+            }
+            out.flush();
+        }
+        
+        // restores a capture into the channels, straight into the latest
+        // values, with the messages as old as they were when it was written;
+        // returns false when the capture isn't valid, what was decoded up to
+        // that point is kept
+        static bool read(const void* data, size_t size, Ticks now, ActiveChannels& channels)
+        {
+            Reader in { static_cast<const uint8*>(data), static_cast<const uint8*>(data) + size };
+            
+            uint32 version, count;
+            if (!in.readByte(version) || version != VERSION || !in.readVarint(count))
+            {
+                return false;
+            }
+            
+            auto t = now;
+            for (uint32 i = 0; i < count; ++i)
+            {
+                uint32 delta, tag, number = 0, value;
+                if (!in.readVarint(delta) || !in.readByte(tag))
+                {
+                    return false;
+                }
+                
+                // a capture with numbers or values that MIDI can't carry
+                // isn't one of ours
+                auto kind = int(tag >> 4);
+                if (kind >= captureKindCount ||
+                    (hasNumber(kind) && !in.readVarint(number)) ||
+                    !in.readVarint(value) ||
+                    number >= uint32(kind <= captureControlChange ? 128 : 16384) ||
+                    value >= uint32(kind < capturePitchBend ? 128 : 16384))
+                {
+                    return false;
+                }
+                
+                // zero means that a message was never received
+                t = std::max(Ticks(1), t - Ticks(delta) * TICKS_PER_MS);
+                restore(channels.writeChannel(int(tag & 0xf)), kind, int(number), int16(uint16(value)), t);
+            }
+            
+            return true;
+        }
+        
+        // appends a capture to the end of the plugin state
+        static void appendTrailer(MemoryBlock& state, const MemoryBlock& capture)
+        {
+            if (capture.getSize() == 0)
+            {
+                return;
+            }
+            
+            MemoryOutputStream out(state, true);
+            out.write(capture.getData(), capture.getSize());
+            out.writeInt(int(capture.getSize()));
+            out.writeInt(int(TRAILER_MAGIC));
+            out.flush();
+        }
+        
+        // finds the capture at the end of the plugin state, if there's one
+        static bool findTrailer(const void* state, int size, MemoryBlock& capture)
+        {
+            if (size < TRAILER_SIZE)
+            {
+                return false;
+            }
+            
+            auto end = static_cast<const uint8*>(state) + size;
+            auto length = ByteOrder::littleEndianInt(end - TRAILER_SIZE);
+            if (ByteOrder::littleEndianInt(end - TRAILER_SIZE / 2) != TRAILER_MAGIC ||
+                length > uint32(size - TRAILER_SIZE))
+            {
+                return false;
+            }
+            
+            capture.replaceAll(end - TRAILER_SIZE - length, length);
+            return true;
+        }
+        
+    private:
+        enum CaptureKind
+        {
+            captureNoteOff,
+            captureNoteOn,
+            capturePolyPressure,
+            captureControlChange,
+            captureProgramChange,
+            captureChannelPressure,
+            capturePitchBend,
+            captureHrcc,
+            captureRpn,
+            captureNrpn,
+            captureKindCount
+        };
+        
+        struct Record
+        {
+            Ticks time_;
+            uint8 tag_;
+            int16 number_;
+            int16 value_;
+        };
+        
+        struct Reader
+        {
+            bool readByte(uint32& value)
+            {
+                if (next_ == end_)
+                {
+                    return false;
+                }
+                value = *next_++;
+                return true;
+            }
+            
+            bool readVarint(uint32& value)
+            {
+                value = 0;
+                for (auto shift = 0; shift < 32; shift += 7)
+                {
+                    uint32 byte;
+                    if (!readByte(byte))
+                    {
+                        return false;
+                    }
+                    value |= (byte & 0x7f) << shift;
+                    if ((byte & 0x80) == 0)
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+            
+            const uint8* next_;
+            const uint8* end_;
+        };
+        
+        static bool hasNumber(int kind)
+        {
+            return kind != captureProgramChange && kind != captureChannelPressure && kind != capturePitchBend;
+        }
+        
+        static void writeVarint(MemoryOutputStream& out, uint32 value)
+        {
+            while (value >= 0x80)
+            {
+                out.writeByte(char(0x80 | (value & 0x7f)));
+                value >>= 7;
+            }
+            out.writeByte(char(value));
+        }
+        
+        static void add(std::vector<Record>& records, int kind, const ActiveChannel& channel, int number, Ticks time, int16 value)
+        {
+            if (time != 0)
+            {
+                records.push_back({ time, uint8((kind << 4) | channel.number_), int16(number), value });
+            }
+        }
+        
+        static void collect(const Parameters& params, int kind, const ActiveChannel& channel, std::vector<Record>& records)
+        {
+            for (auto i = 0; i < params.param_.size(); ++i)
+            {
+                auto number = params.param_.numberAt(i);
+                auto param = params.param_.find(number);
+                add(records, kind, channel, number, param->time_, param->value_);
+            }
+        }
+        
+        static void collect(const ActiveChannels& channels, std::vector<Record>& records)
+        {
+            for (auto channel_index = 0; channel_index < 16; ++channel_index)
+            {
+                auto& channel = channels.channel(channel_index);
+                if (channel.time_ == 0)
+                {
+                    continue;
+                }
+                
+                auto& notes = channel.notes_;
+                for (auto a = 0; a < notes.active_.size(); ++a)
+                {
+                    auto i = notes.active_[a];
+                    add(records, captureNoteOff, channel, i, notes.off_.time_[i], notes.off_.value_[i]);
+                    add(records, captureNoteOn, channel, i, notes.on_.time_[i], notes.on_.value_[i]);
+                    add(records, capturePolyPressure, channel, i, notes.polyPressure_.time_[i], notes.polyPressure_.value_[i]);
+                }
+                
+                auto& control_changes = channel.controlChanges_;
+                for (auto a = 0; a < control_changes.active_.size(); ++a)
+                {
+                    auto i = control_changes.active_[a];
+                    add(records, captureControlChange, channel, i, control_changes.controlChange_.time_[i], control_changes.controlChange_.value_[i]);
+                }
+                
+                add(records, captureProgramChange, channel, 0, channel.programChange_.time_[0], channel.programChange_.value_[0]);
+                add(records, captureChannelPressure, channel, 0, channel.channelPressure_.time_[0], channel.channelPressure_.value_[0]);
+                add(records, capturePitchBend, channel, 0, channel.pitchBend_.time_[0], channel.pitchBend_.value_[0]);
+                
+                collect(channel.hrccs_, captureHrcc, channel, records);
+                collect(channel.rpns_, captureRpn, channel, records);
+                collect(channel.nrpns_, captureNrpn, channel, records);
+            }
+        }
+        
+        static void restore(Parameters& params, int number, int16 value, Ticks t)
+        {
+            auto& param = params.param_[number];
+            param.value_ = value;
+            param.time_ = t;
+            params.time_ = std::max(params.time_, t);
+        }
+        
+        static void restore(ActiveChannel& channel, int kind, int number, int16 value, Ticks t)
+        {
+            channel.time_ = std::max(channel.time_, t);
+            
+            auto& notes = channel.notes_;
+            auto& control_changes = channel.controlChanges_;
+            switch (kind)
+            {
+                case captureNoteOff:
+                case captureNoteOn:
+                case capturePolyPressure:
+                {
+                    // the records come newest first, a note off that's older
+                    // than the one already restored, which is also the one
+                    // of a held note, would make the note held again
+                    if (kind == captureNoteOff && notes.off_.time_[number] >= t)
+                    {
+                        break;
+                    }
+                    
+                    auto& message = kind == captureNoteOff ? static_cast<MessageArray<128>&>(notes.off_) :
+                                    kind == captureNoteOn ? static_cast<MessageArray<128>&>(notes.on_) :
+                                    static_cast<MessageArray<128>&>(notes.polyPressure_);
+                    message.value_[number] = value;
+                    message.time_[number] = t;
+                    notes.active_.add(number);
+                    notes.time_ = std::max(notes.time_, t);
+                    
+                    // the note off of a note that was still held will never
+                    // come, so it's restored as released, otherwise it would
+                    // be kept on display forever
+                    if (kind == captureNoteOn && notes.off_.time_[number] == 0)
+                    {
+                        notes.off_.value_[number] = 0;
+                        notes.off_.time_[number] = t;
+                    }
+                    break;
+                }
+                case captureControlChange:
+                    control_changes.controlChange_.value_[number] = value;
+                    control_changes.controlChange_.time_[number] = t;
+                    control_changes.active_.add(number);
+                    control_changes.time_ = std::max(control_changes.time_, t);
+                    break;
+                case captureProgramChange:
+                    channel.programChange_.value_[0] = value;
+                    channel.programChange_.time_[0] = t;
+                    break;
+                case captureChannelPressure:
+                    channel.channelPressure_.value_[0] = value;
+                    channel.channelPressure_.time_[0] = t;
+                    break;
+                case capturePitchBend:
+                    channel.pitchBend_.value_[0] = value;
+                    channel.pitchBend_.time_[0] = t;
+                    break;
+                case captureHrcc:
+                    restore(channel.hrccs_, number, value, t);
+                    break;
+                case captureRpn:
+                    restore(channel.rpns_, number, value, t);
+                    break;
+                case captureNrpn:
+                    restore(channel.nrpns_, number, value, t);
+                    break;
+            }
+        }
+    };
+}
@@ -96,5 +96,14 @@ namespace showmidi
         
         virtual bool isAutoHideInactiveDevices() = 0;
         virtual void setAutoHideInactiveDevices(bool) = 0;
+        
+        virtual bool isShowAllInstances() = 0;
+        virtual void setShowAllInstances(bool) = 0;
+        
+        virtual bool isStoreSessionCapture() = 0;
+        virtual void setStoreSessionCapture(bool) = 0;
+        
+        virtual bool isMonitorWhileClosed() = 0;
+        virtual void setMonitorWhileClosed(bool) = 0;
     };
 }
@@ -44,6 +44,12 @@ namespace showmidi
             windowAlwaysOnTopButton_ = std::make_unique<PaintedButton>("always on top");
             devicesKeepButton_ = std::make_unique<PaintedButton>("keep");
             devicesAutoHideButton_ = std::make_unique<PaintedButton>("auto-hide");
+            instancesThisButton_ = std::make_unique<PaintedButton>("this");
+            instancesAllButton_ = std::make_unique<PaintedButton>("all");
+            sessionCaptureOffButton_ = std::make_unique<PaintedButton>("off");
+            sessionCaptureStoreButton_ = std::make_unique<PaintedButton>("store");
+            whileClosedMonitorButton_ = std::make_unique<PaintedButton>("monitor");
+            whileClosedBypassButton_ = std::make_unique<PaintedButton>("bypass");
             loadThemeButton_ = std::make_unique<PaintedButton>("load");
             saveThemeButton_ = std::make_unique<PaintedButton>("save");
             graphHeight1Button_ = std::make_unique<PaintedButton>("compact");
@@ -77,6 +83,12 @@ namespace showmidi
             windowAlwaysOnTopButton_->addListener(this);
             devicesKeepButton_->addListener(this);
             devicesAutoHideButton_->addListener(this);
+            instancesThisButton_->addListener(this);
+            instancesAllButton_->addListener(this);
+            sessionCaptureOffButton_->addListener(this);
+            sessionCaptureStoreButton_->addListener(this);
+            whileClosedMonitorButton_->addListener(this);
+            whileClosedBypassButton_->addListener(this);
             graphHeight1Button_->addListener(this);
             graphHeight2Button_->addListener(this);
             graphHeight3Button_->addListener(this);
@@ -126,6 +138,15 @@ namespace showmidi
                 owner_->addAndMakeVisible(devicesKeepButton_.get());
                 owner_->addAndMakeVisible(devicesAutoHideButton_.get());
             }
+            else
+            {
+                owner_->addAndMakeVisible(instancesThisButton_.get());
+                owner_->addAndMakeVisible(instancesAllButton_.get());
+                owner_->addAndMakeVisible(sessionCaptureOffButton_.get());
+                owner_->addAndMakeVisible(sessionCaptureStoreButton_.get());
+                owner_->addAndMakeVisible(whileClosedMonitorButton_.get());
+                owner_->addAndMakeVisible(whileClosedBypassButton_.get());
+            }
             owner_->addAndMakeVisible(graphHeight1Button_.get());
             owner_->addAndMakeVisible(graphHeight2Button_.get());
             owner_->addAndMakeVisible(graphHeight3Button_.get());
@@ -164,7 +185,7 @@ namespace showmidi
         
         void setSettingOptionFont(Graphics& g, std::function<bool()> condition)
         {
-            g.setFont(manager_->getSettings().getTheme().fontData().withStyle(condition() ? Font::underlined : Font::plain));
+            g.setFont(manager_->getSettings().getTheme().fontOption(condition()));
         }
         
         void updateDimensions()
@@ -174,7 +195,7 @@ namespace showmidi
             int height;
             if (manager_->isPlugin())
             {
-                height = theme.linePosition(20.0);
+                height = theme.linePosition(27.5);
             }
             else if (SystemStats::getOperatingSystemType() == SystemStats::iOS)
             {
@@ -263,6 +284,35 @@ namespace showmidi
                 devicesAutoHideButton_->setBoundsForTouch(left_margin + button_spacing, y_offset,
                                                           getWidth(), theme.labelHeight());
             }
+            else
+            {
+                // plugin instances
+                
+                y_offset += row_spacing;
+                
+                instancesThisButton_->setBoundsForTouch(left_margin, y_offset,
+                                                        getWidth(), theme.labelHeight());
+                instancesAllButton_->setBoundsForTouch(left_margin + button_spacing, y_offset,
+                                                       getWidth(), theme.labelHeight());
+                
+                // session capture
+                
+                y_offset += row_spacing;
+                
+                sessionCaptureOffButton_->setBoundsForTouch(left_margin, y_offset,
+                                                            getWidth(), theme.labelHeight());
+                sessionCaptureStoreButton_->setBoundsForTouch(left_margin + button_spacing, y_offset,
+                                                              getWidth(), theme.labelHeight());
+                
+                // while closed
+                
+                y_offset += row_spacing;
+                
+                whileClosedMonitorButton_->setBoundsForTouch(left_margin, y_offset,
+                                                             getWidth(), theme.labelHeight());
+                whileClosedBypassButton_->setBoundsForTouch(left_margin + button_spacing, y_offset,
+                                                            getWidth(), theme.labelHeight());
+            }
             
             // control graph height
             
@@ -448,6 +498,59 @@ namespace showmidi
                 setSettingOptionFont(g, [&settings] () { return settings.isAutoHideInactiveDevices(); });
                 devicesAutoHideButton_->drawName(g, Justification::centredLeft);
             }
+            else
+            {
+                // plugin instances
+                
+                y_offset += row_spacing;
+                
+                g.setColour(theme.colorData);
+                g.setFont(theme.fontLabel());
+                g.drawText("Plugin Instances",
+                           23, y_offset,
+                           getWidth(), theme.labelHeight(),
+                           Justification::centredLeft, true);
+                
+                g.setColour(theme.colorData.withAlpha(0.7f));
+                setSettingOptionFont(g, [&settings] () { return !settings.isShowAllInstances(); });
+                instancesThisButton_->drawName(g, Justification::centredLeft);
+                setSettingOptionFont(g, [&settings] () { return settings.isShowAllInstances(); });
+                instancesAllButton_->drawName(g, Justification::centredLeft);
+                
+                // session capture
+                
+                y_offset += row_spacing;
+                
+                g.setColour(theme.colorData);
+                g.setFont(theme.fontLabel());
+                g.drawText("Session Capture",
+                           23, y_offset,
+                           getWidth(), theme.labelHeight(),
+                           Justification::centredLeft, true);
+                
+                g.setColour(theme.colorData.withAlpha(0.7f));
+                setSettingOptionFont(g, [&settings] () { return !settings.isStoreSessionCapture(); });
+                sessionCaptureOffButton_->drawName(g, Justification::centredLeft);
+                setSettingOptionFont(g, [&settings] () { return settings.isStoreSessionCapture(); });
+                sessionCaptureStoreButton_->drawName(g, Justification::centredLeft);
+                
+                // while closed
+                
+                y_offset += row_spacing;
+                
+                g.setColour(theme.colorData);
+                g.setFont(theme.fontLabel());
+                g.drawText("While Closed",
+                           23, y_offset,
+                           getWidth(), theme.labelHeight(),
+                           Justification::centredLeft, true);
+                
+                g.setColour(theme.colorData.withAlpha(0.7f));
+                setSettingOptionFont(g, [&settings] () { return settings.isMonitorWhileClosed(); });
+                whileClosedMonitorButton_->drawName(g, Justification::centredLeft);
+                setSettingOptionFont(g, [&settings] () { return !settings.isMonitorWhileClosed(); });
+                whileClosedBypassButton_->drawName(g, Justification::centredLeft);
+            }
             
             // control graph height
             
@@ -629,6 +732,36 @@ namespace showmidi
                 settings.setAutoHideInactiveDevices(true);
                 repaint();
             }
+            else if (buttonThatWasClicked == instancesThisButton_.get())
+            {
+                settings.setShowAllInstances(false);
+                repaint();
+            }
+            else if (buttonThatWasClicked == instancesAllButton_.get())
+            {
+                settings.setShowAllInstances(true);
+                repaint();
+            }
+            else if (buttonThatWasClicked == sessionCaptureOffButton_.get())
+            {
+                settings.setStoreSessionCapture(false);
+                repaint();
+            }
+            else if (buttonThatWasClicked == sessionCaptureStoreButton_.get())
+            {
+                settings.setStoreSessionCapture(true);
+                repaint();
+            }
+            else if (buttonThatWasClicked == whileClosedMonitorButton_.get())
+            {
+                settings.setMonitorWhileClosed(true);
+                repaint();
+            }
+            else if (buttonThatWasClicked == whileClosedBypassButton_.get())
+            {
+                settings.setMonitorWhileClosed(false);
+                repaint();
+            }
             else if (buttonThatWasClicked == graphHeight1Button_.get())
             {
                 settings.setControlGraphHeight(1);
@@ -807,6 +940,12 @@ namespace showmidi
         std::unique_ptr<PaintedButton> windowAlwaysOnTopButton_;
         std::unique_ptr<PaintedButton> devicesKeepButton_;
         std::unique_ptr<PaintedButton> devicesAutoHideButton_;
+        std::unique_ptr<PaintedButton> instancesThisButton_;
+        std::unique_ptr<PaintedButton> instancesAllButton_;
+        std::unique_ptr<PaintedButton> sessionCaptureOffButton_;
+        std::unique_ptr<PaintedButton> sessionCaptureStoreButton_;
+        std::unique_ptr<PaintedButton> whileClosedMonitorButton_;
+        std::unique_ptr<PaintedButton> whileClosedBypassButton_;
         std::unique_ptr<PaintedButton> graphHeight1Button_;
         std::unique_ptr<PaintedButton> graphHeight2Button_;
         std::unique_ptr<PaintedButton> graphHeight3Button_;
@@ -163,12 +163,18 @@ namespace showmidi
                 layoutDevices();
             }
 
+            // hidden devices render too, since that's when their queued MIDI
+            // is applied to their channel state
+            for (HashMap<const String, MidiDeviceComponent*>::Iterator i(midiDevices_); i.next();)
+            {
+                i.getValue()->render();
+            }
+
             auto height = owner_->getParentHeight();
             for (auto&& identifier : shownDevices_)
             {
                 auto c = midiDevices_[identifier];
                 if (c == nullptr) continue;
-                c->render();
                 height = std::max(height, c->getVisibleHeight());
             }
             
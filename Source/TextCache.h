@@ -0,0 +1,104 @@
+/*
+ * This file is part of ShowMIDI.
+ * Copyright (command) 2023 Uwyn LLC.  https://www.uwyn.com
+ *
+ * ShowMIDI is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ShowMIDI is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <unordered_map>
+
+namespace showmidi
+{
+    // the glyph arrangements of recently drawn texts, so that a text in the
+    // same font and box is only laid out once, later frames just draw its
+    // glyphs at a new position; the colour and the display scale are applied
+    // when drawing, so they're not part of what's cached
+    class TextCache
+    {
+    public:
+        // when values keep changing the cache starts over, the fixed
+        // vocabulary of labels and numbers is quickly laid out again
+        static constexpr size_t MAX_ENTRIES = 4096;
+        
+        TextCache() = default;
+        
+        // draws like Graphics::drawText with the current font, curtailing
+        // texts that are too wide with an ellipsis
+        void draw(Graphics& g, const String& text, int x, int y, int width, int height, Justification justification)
+        {
+            if (text.isEmpty() || !g.clipRegionIntersects({ x, y, width, height }))
+            {
+                return;
+            }
+            
+            Key key { text, g.getCurrentFont(), width, height, justification.getFlags() };
+            auto it = arrangements_.find(key);
+            if (it == arrangements_.end())
+            {
+                if (arrangements_.size() >= MAX_ENTRIES)
+                {
+                    arrangements_.clear();
+                }
+                
+                GlyphArrangement arrangement;
+                arrangement.addCurtailedLineOfText(key.font_, text, 0.0f, 0.0f, float(width), true);
+                arrangement.justifyGlyphs(0, arrangement.getNumGlyphs(), 0.0f, 0.0f, float(width), float(height), justification);
+                it = arrangements_.emplace(std::move(key), std::move(arrangement)).first;
+            }
+            
+            it->second.draw(g, AffineTransform::translation(float(x), float(y)));
+        }
+        
+        void clear()
+        {
+            arrangements_.clear();
+        }
+        
+    private:
+        struct Key
+        {
+            bool operator==(const Key& other) const
+            {
+                return width_ == other.width_ && height_ == other.height_ && justification_ == other.justification_ &&
+                       text_ == other.text_ && font_ == other.font_;
+            }
+            
+            String text_;
+            Font font_;
+            int width_;
+            int height_;
+            int justification_;
+        };
+        
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const
+            {
+                auto hash = size_t(key.text_.hash());
+                hash = hash * 31 + size_t(key.width_);
+                hash = hash * 31 + size_t(key.height_);
+                hash = hash * 31 + size_t(key.justification_);
+                hash = hash * 31 + size_t(key.font_.getStyleFlags());
+                return hash * 31 + size_t(key.font_.getHeight() * 100.0f);
+            }
+        };
+        
+        std::unordered_map<Key, GlyphArrangement, KeyHash> arrangements_;
+        
+        JUCE_DECLARE_NON_COPYABLE (TextCache)
+    };
+}
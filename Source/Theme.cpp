@@ -62,24 +62,48 @@ namespace showmidi
         return (int)(lineHeight() * number);
     }
 
-    Font Theme::fontLabel()
+    ThemeFonts::ThemeFonts() :
+        label_(16, Font::bold),
+        data_(16, Font::italic),
+        option_(16, Font::plain),
+        optionSelected_(16, Font::underlined),
+        labelHeight_((int)label_.getHeight()),
+        dataHeight_((int)data_.getHeight())
     {
-        return Font(16, Font::bold);
+    }
+    
+    const ThemeFonts& Theme::fonts()
+    {
+        if (fonts_ == nullptr)
+        {
+            fonts_ = std::make_shared<const ThemeFonts>();
+        }
+        return *fonts_;
+    }
+
+    const Font& Theme::fontLabel()
+    {
+        return fonts().label_;
     }
 
     int Theme::labelHeight()
     {
-        return (int)fontLabel().getHeight();
+        return fonts().labelHeight_;
     }
     
-    Font Theme::fontData()
+    const Font& Theme::fontData()
     {
-        return Font(16, Font::italic);
+        return fonts().data_;
     }
 
     int Theme::dataHeight()
     {
-        return (int)fontData().getHeight();
+        return fonts().dataHeight_;
+    }
+    
+    const Font& Theme::fontOption(bool selected)
+    {
+        return selected ? fonts().optionSelected_ : fonts().option_;
     }
     
     String Theme::generateXml()
@@ -21,6 +21,21 @@
 
 namespace showmidi
 {
+    // the fonts of a theme and their metrics, built once since the paint
+    // functions ask for them for every item they draw; they're in logical
+    // pixels, the display scale is only applied when painting
+    struct ThemeFonts
+    {
+        ThemeFonts();
+        
+        Font label_;
+        Font data_;
+        Font option_;
+        Font optionSelected_;
+        int labelHeight_;
+        int dataHeight_;
+    };
+    
     struct Theme
     {
         static constexpr int MIDI_DEVICE_SPACING = 2;
@@ -32,10 +47,11 @@ namespace showmidi
         int linePosition(float);
         int getSidebarExpandedWidth();
         
-        Font fontLabel();
+        const Font& fontLabel();
         int labelHeight();
-        Font fontData();
+        const Font& fontData();
         int dataHeight();
+        const Font& fontOption(bool selected);
         
         String generateXml();
         void parseXml(const String&);
@@ -54,6 +70,12 @@ namespace showmidi
         Colour colorPositive;
         Colour colorNegative;
         Colour colorController;
+        
+        // the fonts don't depend on the colors, so copies of a theme share them
+        std::shared_ptr<const ThemeFonts> fonts_;
+        
+    private:
+        const ThemeFonts& fonts();
     };
     
     static const Theme THEME_DARK =